@@ -0,0 +1,174 @@
+// =============================================================================
+// bench - fixed-workload speed measurements for the engine library.
+//
+//   bench [perft|movegen|search|all] [search depth]
+//
+//   perft    perft of the five Chess Programming Wiki positions (node counts
+//            double as a correctness check) - move generation + make/unmake.
+//   movegen  the generators alone (pseudo-legal ALL, CAPTURES, legal, and legal
+//            with the side to move in check), repeated over fixed position
+//            sets: raw speed without make/unmake.
+//   search   a fixed-depth search of each position with a fresh engine; the
+//            node total is the search's signature (any change to it means the
+//            search itself changed), nodes/s is its speed. Also counts the
+//            static evals the backend ran and those answered lazily by the
+//            material+PSQT estimate. Runs once with the HCE and once with the
+//            embedded NNUE net (if the binary has one).
+//
+// Single-threaded and deterministic: compare two builds by running both.
+// =============================================================================
+
+#include "chess/movegen.hpp"
+#include "chess/movelist.hpp"
+#include "chess/nnue.hpp"
+#include "chess/position.hpp"
+#include "chess/search.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace chess;
+
+namespace {
+
+struct PerftCase { const char* fen; int depth; std::uint64_t nodes; };
+
+// The reference values are the published ones (also checked by core_tests).
+const PerftCase PERFT_CASES[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",             5,   4865609 },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,   4085603 },
+    { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",                           6,  11030083 },
+    { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",    5,  15833292 },
+    { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",           4,   2103487 },
+};
+
+// Middlegame-heavy set for movegen and search (plus the perft positions).
+const char* BENCH_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 1 8",
+    "r2q1rk1/1b1nbppp/p2ppn2/1p6/3NP3/1BN1BP2/PPPQ2PP/2KR3R w - - 0 12",
+    "2rq1rk1/pb2bppp/1pn1pn2/2pp4/3P4/1PPBPN2/PB1N1PPP/R2Q1RK1 w - - 0 11",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+    "4r1k1/1p3pp1/p1p4p/3r4/3P4/1P3P2/P4KPP/2R1R3 b - - 0 24",
+};
+
+// Side to move in check (single and double check, sliders, knights, pawns).
+const char* CHECK_FENS[] = {
+    "rnbqkbnr/ppp2ppp/8/1B1pp3/4P3/8/PPPP1PPP/RNBQK1NR b KQkq - 1 3",
+    "rnbqk1nr/pppp1ppp/8/4p3/1b6/3P4/PPP1PPPP/RNBQKBNR w KQkq - 1 3",
+    "r1bqkbnr/pppp1ppp/8/4p3/4P3/3n4/PPPP1PPP/RNBQKBNR w KQkq - 0 4",
+    "4k3/8/8/8/8/5n2/8/R3K2R w KQ - 0 1",
+    "4k3/8/8/8/8/3n4/8/r3K3 w - - 0 1",
+    "4k3/8/8/1b6/8/8/3p4/4K1n1 w - - 0 1",
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+bool bench_perft() {
+    std::printf("perft\n");
+    std::uint64_t total = 0;
+    bool ok = true;
+    const auto t0 = Clock::now();
+    for (const PerftCase& c : PERFT_CASES) {
+        Position pos; pos.set_fen(c.fen);
+        const auto t = Clock::now();
+        const std::uint64_t n = perft(pos, c.depth);
+        const double s = seconds_since(t);
+        std::printf("  depth %d  %10llu nodes  %7.1f Mnps  %s\n", c.depth,
+                    static_cast<unsigned long long>(n), n / s / 1e6,
+                    n == c.nodes ? "ok" : "MISMATCH");
+        ok = ok && n == c.nodes;
+        total += n;
+    }
+    const double s = seconds_since(t0);
+    std::printf("  total %llu nodes in %.3f s: %.1f Mnps\n",
+                static_cast<unsigned long long>(total), s, total / s / 1e6);
+    return ok;
+}
+
+// Time `gen` over the position set; `label` names the generator measured.
+template <class Gen, std::size_t N>
+void time_generator(const char* label, const char* const (&fens)[N], Gen gen) {
+    constexpr int REPEAT = 200000;
+    std::uint64_t moves = 0, calls = 0;
+    const auto t0 = Clock::now();
+    for (const char* fen : fens) {
+        Position pos; pos.set_fen(fen);
+        for (int i = 0; i < REPEAT; ++i) {
+            MoveList list;
+            gen(pos, list);
+            moves += list.size();
+        }
+        calls += REPEAT;
+    }
+    const double s = seconds_since(t0);
+    std::printf("  %-16s %llu calls, %llu moves in %.3f s: %.1f ns/call\n", label,
+                static_cast<unsigned long long>(calls), static_cast<unsigned long long>(moves),
+                s, s * 1e9 / calls);
+}
+
+void bench_movegen() {
+    std::printf("movegen\n");
+    time_generator("pseudo-legal", BENCH_FENS, [](Position& p, MoveList& l) { generate<ALL>(p, l); });
+    time_generator("captures", BENCH_FENS, [](Position& p, MoveList& l) { generate<CAPTURES>(p, l); });
+    time_generator("legal", BENCH_FENS, [](Position& p, MoveList& l) { generate_legal(p, l); });
+    time_generator("legal in check", CHECK_FENS, [](Position& p, MoveList& l) { generate_legal(p, l); });
+}
+
+void bench_search(int depth, const char* label) {
+    std::printf("search depth %d (%s)\n", depth, label);
+    std::uint64_t nodes = 0, evals = 0, lazy = 0;
+    const auto t0 = Clock::now();
+    for (const char* fen : BENCH_FENS) {
+        Position pos; pos.set_fen(fen);
+        SearchEngine engine(16);
+        const SearchResult r = engine.search(pos, SearchLimits{depth, 0, 0});
+        nodes += r.nodes;
+        evals += r.evals;
+        lazy  += r.lazyEvals;
+    }
+    const double s = seconds_since(t0);
+    std::printf("  %llu nodes in %.3f s: %.0f nps\n",
+                static_cast<unsigned long long>(nodes), s, nodes / s);
+    std::printf("  %llu evals, %llu lazy (%.1f%%), %.2f evals/node\n",
+                static_cast<unsigned long long>(evals), static_cast<unsigned long long>(lazy),
+                100.0 * lazy / std::max<std::uint64_t>(1, evals + lazy),
+                double(evals) / std::max<std::uint64_t>(1, nodes));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string what = argc > 1 ? argv[1] : "all";
+    const int depth = argc > 2 ? std::max(1, std::atoi(argv[2])) : 11;
+
+    {   // the first attack lookups build the magic tables: keep that out of the timings
+        Position warm; warm.set_startpos();
+        perft(warm, 2);
+    }
+
+    bool ok = true;
+    if (what == "perft" || what == "all") ok = bench_perft();
+    if (what == "movegen" || what == "all") bench_movegen();
+    if (what == "search" || what == "all") {
+        nnue::unload();
+        bench_search(depth, "HCE");
+        if (nnue::load_embedded()) bench_search(depth, "NNUE");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+// =============================================================================
+// convert_data - translate training data between gen_data's two formats.
+//
+//   convert_data <in.txt> <out.bin>              text -> 32-byte packed records
+//   convert_data --to-text <in.bin> <out.txt>    packed -> text (for inspection)
+//
+// The text -> packed direction replaces the old normalize + `bullet-utils
+// convert` steps of tools/training/retrain.ps1: result tokens are normalized on
+// the way in ("1"/"1.0", "0"/"0.0", else draw) and the output is bullet's own
+// ChessBoard layout (chess/packed.hpp). Malformed lines are counted and skipped.
+// Converted text carries no best move; the ply comes from the FEN's move number.
+//
+// The packed -> text direction cannot restore castling rights, en passant or the
+// clocks (the format does not store them), so its FENs have "- - 0 1" there.
+// =============================================================================
+
+#include "chess/packed.hpp"
+#include "chess/position.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+int text_to_packed(const std::string& in, const std::string& out) {
+    std::ifstream f(in);
+    if (!f) { std::cerr << "cannot open " << in << "\n"; return 1; }
+    std::ofstream g(out, std::ios::binary);
+    if (!g) { std::cerr << "cannot open " << out << "\n"; return 1; }
+
+    std::vector<PackedBoard> batch;
+    batch.reserve(1 << 15);
+    std::uint64_t ok = 0, bad = 0;
+    std::string line;
+    auto flush = [&] {
+        g.write(reinterpret_cast<const char*>(batch.data()),
+                std::streamsize(batch.size() * sizeof(PackedBoard)));
+        batch.clear();
+    };
+    while (std::getline(f, line)) {
+        if (line.empty() || line == "\r") continue;
+        PackedBoard b;
+        if (!parse_text_record(line, b)) { ++bad; continue; }
+        batch.push_back(b);
+        ++ok;
+        if (batch.size() == batch.capacity()) flush();
+    }
+    flush();
+    std::cerr << "converted " << ok << " records (" << bad << " malformed lines skipped) -> "
+              << out << "\n";
+    return 0;
+}
+
+int packed_to_text(const std::string& in, const std::string& out) {
+    PackedReader r;
+    if (!r.open(in)) { std::cerr << "cannot open " << in << "\n"; return 1; }
+    std::ofstream g(out);
+    if (!g) { std::cerr << "cannot open " << out << "\n"; return 1; }
+
+    std::vector<PackedBoard> batch(1 << 15);
+    std::uint64_t n = 0;
+    Position pos;
+    for (std::size_t got; (got = r.read(batch.data(), batch.size())) > 0; ) {
+        for (std::size_t i = 0; i < got; ++i) {
+            const PackedBoard& b = batch[i];
+            b.unpack(pos);
+            const double res = b.white_result();
+            g << pos.to_fen() << " | " << b.white_score() << " | "
+              << (res == 1.0 ? "1.0" : res == 0.0 ? "0.0" : "0.5") << "\n";
+        }
+        n += got;
+    }
+    std::cerr << "wrote " << n << " lines -> " << out << "\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 4 && std::string(argv[1]) == "--to-text")
+        return packed_to_text(argv[2], argv[3]);
+    if (argc == 3)
+        return text_to_packed(argv[1], argv[2]);
+
+    std::cerr << "usage: convert_data <in.txt> <out.bin>\n"
+                 "       convert_data --to-text <in.bin> <out.txt>\n";
+    return 1;
+}
@@ -0,0 +1,377 @@
+// =============================================================================
+// dataprep - out-of-core preparation of packed training data (chess/packed.hpp):
+// filter, dedupe, shuffle, and split into train / validation files.
+//
+//   dataprep <out-prefix> <in.bin>... [--threads N] [--mem MB] [--val F]
+//            [--max-score CP] [--min-ply N] [--skip-check] [--skip-captures]
+//            [--seed S] [--tmp DIR]
+//
+// Writes <out-prefix>.train.bin and <out-prefix>.val.bin (same record format).
+//
+// Two passes, with memory bounded by --mem whatever the input size:
+//   1. Partition. Inputs are mmapped and cut into chunks that the threads pull
+//      from a shared counter. Each record is decoded, filtered, keyed by its
+//      Zobrist hash and appended to one of S temp shards chosen by that hash.
+//      The hash is effectively random, so every shard is a uniform random sample
+//      of the data - and every copy of a position lands in the same shard.
+//      At most MAX_OPEN_SHARDS shard files are open at once: with more shards,
+//      pass 1 runs in batches, each scan keeping only its batch's shards.
+//   2. Per shard (threads pull shards; S is chosen so PASS2_SLOTS shards fit in
+//      --mem, and at most that many are in memory at once): sort by key and keep one record per key (dedupe is exact -
+//      duplicates never straddle shards), shuffle with an RNG seeded by
+//      (seed, shard), and route each position to train or validation by its key
+//      hash, so the same position never sits on both sides. Shards are appended
+//      to the outputs strictly in shard order.
+// Concatenating independently shuffled uniform random shards is a uniform shuffle
+// of the whole set. The output is a pure function of the inputs, --seed and the
+// shard count (derived from --mem alone), never of --threads or scheduling.
+//
+// Filters: --max-score drops |score| > CP, --min-ply drops early opening plies,
+// --skip-check drops side-to-move-in-check positions, --skip-captures drops
+// positions whose recorded best move is a capture (records converted from text
+// carry no best move and are kept).
+// =============================================================================
+
+#include "chess/mapped_file.hpp"
+#include "chess/packed.hpp"
+#include "chess/position.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chess;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    std::string              outPrefix;
+    std::vector<std::string> inputs;
+    std::string              tmpDir;
+    int                      threads      = 1;
+    std::size_t              memMb        = 2048;
+    double                   valFraction  = 0.01;
+    int                      maxScore     = 0;      // 0 = no score filter
+    int                      minPly       = 0;
+    bool                     skipCheck    = false;
+    bool                     skipCaptures = false;
+    std::uint64_t            seed         = 1;
+};
+
+// A temp-shard entry: the record plus its key, so pass 2 never re-decodes.
+struct Entry {
+    std::uint64_t key;
+    PackedBoard   rec;
+};
+static_assert(sizeof(Entry) == 40, "temp shard entries are written raw");
+
+constexpr std::size_t CHUNK_RECORDS = std::size_t(1) << 20;   // pass-1 work unit
+constexpr std::size_t PASS2_BYTES_PER_RECORD = sizeof(Entry) + sizeof(PackedBoard);
+constexpr std::size_t PASS2_SLOTS     = 8;     // shards in memory at once in pass 2
+constexpr std::size_t MAX_OPEN_SHARDS = 256;   // shard files open at once in pass 1 (fd limit)
+
+// SplitMix64 finalizer: turns Zobrist keys (and seeds) into uniform hash bits.
+std::uint64_t mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+struct Stats {
+    std::atomic<std::uint64_t> read{0}, byScore{0}, byPly{0}, byCheck{0}, byCapture{0};
+    std::atomic<std::uint64_t> duplicates{0}, train{0}, val{0};
+};
+
+// Apply the filters; on success `key` is the record's Zobrist key. The cheap
+// field tests run before the decode.
+bool keep(const PackedBoard& b, const Options& o, Stats& st, Position& pos, std::uint64_t& key) {
+    if (o.maxScore > 0 && std::abs(int(b.score)) > o.maxScore) { ++st.byScore; return false; }
+    if (b.ply() < o.minPly)                                     { ++st.byPly;   return false; }
+
+    b.unpack(pos);
+    if (o.skipCheck && pos.in_check()) { ++st.byCheck; return false; }
+    if (o.skipCaptures) {
+        Move m = b.best_move(pos);
+        if (m != MOVE_NONE && (m.type_of() == EN_PASSANT || !pos.empty(m.to_sq()))) {
+            ++st.byCapture;
+            return false;
+        }
+    }
+    key = pos.key();
+    return true;
+}
+
+// The S temp shard files, each appended to under its own lock. Only the
+// current pass-1 batch [lo, hi) has its files open.
+struct Shards {
+    std::vector<std::string>                   paths;
+    std::vector<std::ofstream>                 files;   // [hi - lo]: the open batch
+    std::unique_ptr<std::mutex[]>              locks;
+    std::size_t                                lo = 0, hi = 0;
+
+    std::size_t count() const { return paths.size(); }
+    std::size_t index(std::uint64_t key) const { return std::size_t(mix64(key) % paths.size()); }
+
+    void append(std::size_t s, const std::vector<Entry>& buf) {
+        std::lock_guard<std::mutex> lk(locks[s - lo]);
+        files[s - lo].write(reinterpret_cast<const char*>(buf.data()),
+                            std::streamsize(buf.size() * sizeof(Entry)));
+    }
+};
+
+// ---- Pass 1: filter + key + partition ---------------------------------------
+struct Chunk {
+    const PackedBoard* recs;
+    std::size_t        n;
+};
+
+void partition_worker(const std::vector<Chunk>& chunks, std::atomic<std::size_t>& next,
+                      Shards& shards, std::size_t bufEntries, const Options& o, Stats& st) {
+    // Per-thread staging buffers, one per shard of the batch, flushed when full.
+    std::vector<std::vector<Entry>> bufs(shards.hi - shards.lo);
+    for (auto& b : bufs) b.reserve(bufEntries);
+    Position pos;
+
+    for (std::size_t c; (c = next.fetch_add(1)) < chunks.size(); ) {
+        const Chunk& ch = chunks[c];
+        for (std::size_t i = 0; i < ch.n; ++i) {
+            std::uint64_t key;
+            if (!keep(ch.recs[i], o, st, pos, key)) continue;
+            const std::size_t s = shards.index(key);
+            if (s < shards.lo || s >= shards.hi) continue;   // another batch's shard
+            std::vector<Entry>& b = bufs[s - shards.lo];
+            b.push_back(Entry{ key, ch.recs[i] });
+            if (b.size() == bufEntries) { shards.append(s, b); b.clear(); }
+        }
+        st.read.fetch_add(ch.n, std::memory_order_relaxed);
+    }
+    for (std::size_t k = 0; k < bufs.size(); ++k)
+        if (!bufs[k].empty()) shards.append(shards.lo + k, bufs[k]);
+}
+
+// ---- Pass 2: dedupe + shuffle + split, committed in shard order -------------
+struct Outputs {
+    std::ofstream           train, val;
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::size_t             turn = 0;   // the shard whose output goes next
+    bool                    failed = false;   // a shard could not be read back
+};
+
+// Read a whole temp shard; false (with a message) if it is missing, not a
+// whole number of entries, or comes back short.
+bool read_shard(const std::string& path, std::vector<Entry>& e) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    const std::streamoff bytes = f ? std::streamoff(f.tellg()) : -1;
+    if (bytes < 0 || bytes % std::streamoff(sizeof(Entry)) != 0) {
+        std::cerr << "\nerror: cannot read shard " << path << "\n";
+        return false;
+    }
+    e.resize(std::size_t(bytes) / sizeof(Entry));
+    f.seekg(0);
+    f.read(reinterpret_cast<char*>(e.data()), std::streamsize(bytes));
+    if (f.gcount() != bytes) {
+        std::cerr << "\nerror: short read on shard " << path << " (" << f.gcount()
+                  << " of " << bytes << " bytes)\n";
+        e.clear();
+        return false;
+    }
+    return true;
+}
+
+void shard_worker(const Shards& shards, std::atomic<std::size_t>& next, Outputs& out,
+                  const Options& o, Stats& st) {
+    const std::uint64_t valCut = std::uint64_t(o.valFraction * 18446744073709551615.0);
+
+    for (std::size_t s; (s = next.fetch_add(1)) < shards.count(); ) {
+        // A failed shard still takes its turn (writing nothing) so the shards
+        // after it are not left waiting; main then discards the outputs.
+        std::vector<Entry> e;
+        const bool ok = read_shard(shards.paths[s], e);
+        fs::remove(shards.paths[s]);
+
+        // Sort by key, ties by record bytes, so which duplicate survives does not
+        // depend on the (thread-interleaved) order pass 1 appended them in.
+        std::sort(e.begin(), e.end(), [](const Entry& a, const Entry& b) {
+            if (a.key != b.key) return a.key < b.key;
+            return std::memcmp(&a.rec, &b.rec, sizeof(PackedBoard)) < 0;
+        });
+        const std::size_t before = e.size();
+        e.erase(std::unique(e.begin(), e.end(),
+                            [](const Entry& a, const Entry& b) { return a.key == b.key; }),
+                e.end());
+        st.duplicates.fetch_add(before - e.size(), std::memory_order_relaxed);
+
+        std::mt19937_64 rng(mix64(o.seed ^ mix64(s + 1)));
+        std::shuffle(e.begin(), e.end(), rng);
+
+        std::vector<PackedBoard> train, val;
+        train.reserve(e.size());
+        for (const Entry& x : e)
+            (mix64(x.key ^ 0x5851F42D4C957F2DULL) < valCut ? val : train).push_back(x.rec);
+        std::vector<Entry>().swap(e);   // release before waiting our turn
+
+        std::unique_lock<std::mutex> lk(out.mtx);
+        out.cv.wait(lk, [&] { return out.turn == s; });
+        if (!ok) out.failed = true;
+        out.train.write(reinterpret_cast<const char*>(train.data()),
+                        std::streamsize(train.size() * sizeof(PackedBoard)));
+        out.val.write(reinterpret_cast<const char*>(val.data()),
+                      std::streamsize(val.size() * sizeof(PackedBoard)));
+        st.train += train.size();
+        st.val   += val.size();
+        ++out.turn;
+        std::cerr << "\rshards " << out.turn << "/" << shards.count() << std::flush;
+        lk.unlock();
+        out.cv.notify_all();
+    }
+}
+
+bool parse_args(int argc, char** argv, Options& o) {
+    o.threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> pos;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto val = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : "0"; };
+        if      (a == "--threads")       o.threads      = std::max(1, std::atoi(val()));
+        else if (a == "--mem")           o.memMb        = std::size_t(std::max(1, std::atoi(val())));
+        else if (a == "--val")           o.valFraction  = std::clamp(std::atof(val()), 0.0, 1.0);
+        else if (a == "--max-score")     o.maxScore     = std::max(0, std::atoi(val()));
+        else if (a == "--min-ply")       o.minPly       = std::max(0, std::atoi(val()));
+        else if (a == "--skip-check")    o.skipCheck    = true;
+        else if (a == "--skip-captures") o.skipCaptures = true;
+        else if (a == "--seed")          o.seed         = std::strtoull(val(), nullptr, 10);
+        else if (a == "--tmp")           o.tmpDir       = val();
+        else pos.push_back(a);
+    }
+    if (pos.size() < 2) return false;
+    o.outPrefix = pos[0];
+    o.inputs.assign(pos.begin() + 1, pos.end());
+    if (o.tmpDir.empty()) {
+        fs::path parent = fs::path(o.outPrefix).parent_path();
+        o.tmpDir = parent.empty() ? "." : parent.string();
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parse_args(argc, argv, o)) {
+        std::cerr << "usage: dataprep <out-prefix> <in.bin>... [--threads N] [--mem MB=2048]\n"
+                     "                [--val F=0.01] [--max-score CP] [--min-ply N]\n"
+                     "                [--skip-check] [--skip-captures] [--seed S=1] [--tmp DIR]\n"
+                     "  writes <out-prefix>.train.bin and <out-prefix>.val.bin\n";
+        return 1;
+    }
+
+    // Map every input and cut it into pass-1 chunks.
+    std::vector<MappedFile> maps(o.inputs.size());
+    std::vector<Chunk>      chunks;
+    std::uint64_t           total = 0;
+    for (std::size_t i = 0; i < o.inputs.size(); ++i) {
+        if (!maps[i].open(o.inputs[i])) { std::cerr << "cannot map " << o.inputs[i] << "\n"; return 1; }
+        if (maps[i].size() % sizeof(PackedBoard))
+            std::cerr << "warning: " << o.inputs[i] << " has a partial trailing record (ignored)\n";
+        const std::size_t n = maps[i].size() / sizeof(PackedBoard);
+        const auto* recs = reinterpret_cast<const PackedBoard*>(maps[i].data());
+        for (std::size_t b = 0; b < n; b += CHUNK_RECORDS)
+            chunks.push_back(Chunk{ recs + b, std::min(CHUNK_RECORDS, n - b) });
+        total += n;
+    }
+
+    // Enough shards that PASS2_SLOTS of them fit in the budget at once in pass
+    // 2 - from --mem alone, so --threads never changes the partition (and with
+    // it the output). Pass-1 staging buffers (threads x open shards) take at
+    // most a quarter of the budget.
+    const std::uint64_t memBytes = std::uint64_t(o.memMb) << 20;
+    const std::uint64_t slotBytes = std::max<std::uint64_t>(1, memBytes / PASS2_SLOTS);
+    const std::size_t nShards = std::size_t(std::max<std::uint64_t>(1,
+        (total * PASS2_BYTES_PER_RECORD + slotBytes - 1) / slotBytes));
+    const std::size_t batch   = std::min(nShards, MAX_OPEN_SHARDS);
+    const std::size_t bufEntries = std::size_t(std::clamp<std::uint64_t>(
+        memBytes / 4 / (std::uint64_t(o.threads) * batch * sizeof(Entry)), 64, 4096));
+    const int pass2Threads = int(std::min<std::size_t>(std::size_t(o.threads), PASS2_SLOTS));
+
+    std::cerr << "inputs: " << o.inputs.size() << " file(s), " << total << " records; "
+              << o.threads << " thread(s), " << nShards << " shard(s) in " << o.tmpDir
+              << ((nShards + batch - 1) / batch > 1
+                      ? ", " + std::to_string((nShards + batch - 1) / batch) + " pass-1 batches" : "")
+              << "\n";
+
+    Shards shards;
+    shards.locks = std::make_unique<std::mutex[]>(batch);
+    for (std::size_t s = 0; s < nShards; ++s) {
+        std::string name = fs::path(o.outPrefix).filename().string() + ".shard" + std::to_string(s) + ".tmp";
+        shards.paths.push_back((fs::path(o.tmpDir) / name).string());
+    }
+
+    Stats st;
+    for (shards.lo = 0; shards.lo < nShards; shards.lo = shards.hi) {   // ---- pass 1 ----
+        shards.hi = std::min(nShards, shards.lo + batch);
+        shards.files.clear();
+        for (std::size_t s = shards.lo; s < shards.hi; ++s) {
+            shards.files.emplace_back(shards.paths[s], std::ios::binary | std::ios::trunc);
+            if (!shards.files.back()) { std::cerr << "cannot create " << shards.paths[s] << "\n"; return 1; }
+        }
+        Stats rescan;   // later batches see the same records: count them once
+        std::atomic<std::size_t> next{0};
+        std::vector<std::thread> pool;
+        for (int t = 0; t < o.threads; ++t)
+            pool.emplace_back(partition_worker, std::cref(chunks), std::ref(next), std::ref(shards),
+                              bufEntries, std::cref(o), std::ref(shards.lo == 0 ? st : rescan));
+        for (auto& t : pool) t.join();
+        for (std::size_t s = shards.lo; s < shards.hi; ++s) {
+            std::ofstream& f = shards.files[s - shards.lo];
+            f.close();
+            if (!f) { std::cerr << "error: writing " << shards.paths[s] << " failed\n"; return 1; }
+        }
+    }
+    shards.files.clear();
+    maps.clear();   // inputs are no longer needed
+    const std::uint64_t filtered = st.byScore + st.byPly + st.byCheck + st.byCapture;
+    std::cerr << "pass 1: read " << st.read << ", filtered " << filtered
+              << " (score " << st.byScore << ", ply " << st.byPly << ", check " << st.byCheck
+              << ", capture " << st.byCapture << ")\n";
+
+    Outputs out;
+    out.train.open(o.outPrefix + ".train.bin", std::ios::binary | std::ios::trunc);
+    out.val.open(o.outPrefix + ".val.bin", std::ios::binary | std::ios::trunc);
+    if (!out.train || !out.val) { std::cerr << "cannot create outputs at " << o.outPrefix << "\n"; return 1; }
+
+    {   // ---- pass 2 ----
+        std::atomic<std::size_t> next{0};
+        std::vector<std::thread> pool;
+        for (int t = 0; t < pass2Threads; ++t)
+            pool.emplace_back(shard_worker, std::cref(shards), std::ref(next), std::ref(out),
+                              std::cref(o), std::ref(st));
+        for (auto& t : pool) t.join();
+    }
+    if (out.failed) {
+        out.train.close();
+        out.val.close();
+        fs::remove(o.outPrefix + ".train.bin");
+        fs::remove(o.outPrefix + ".val.bin");
+        std::cerr << "failed: a temp shard could not be read back; outputs removed\n";
+        return 1;
+    }
+
+    std::cerr << "\ndone: " << st.duplicates << " duplicates removed; "
+              << st.train << " train -> " << o.outPrefix << ".train.bin, "
+              << st.val << " val -> " << o.outPrefix << ".val.bin\n";
+    return 0;
+}
@@ -9,10 +9,20 @@
 // outcome (1.0 / 0.5 / 0.0 for White). This "score + game result" pairing is the
 // standard NNUE training target; `bullet` consumes exactly this.
 //
-//   gen_data <out.txt> [games] [nodes] [seed]
+//   gen_data <out> [games] [nodes] [seed] [evalfile] [--threads N] [--hash MB] [--binary]
 //
-// Single-threaded and deterministic given the seed, so runs are reproducible and
-// shardable (run N copies with different seeds + output files, then concatenate).
+// --binary writes 32-byte PackedBoard records (chess/packed.hpp) instead of text:
+// bullet's own ChessBoard layout, so the file trains directly with no conversion
+// pass, at about half the text size and with no FEN string building per position.
+// The records also carry the best move and game ply for tools/dataprep.
+//
+// --threads N runs N game loops in ONE process (default 1). Games are handed out
+// by index from a shared counter; each loop owns a small private TT (--hash MB,
+// default 2) and each game draws from its own RNG stream split from the seed, so
+// game g plays the same moves whichever thread picks it up. Finished games go to
+// a single buffered writer thread that emits them in game-index order: the output
+// is byte-identical for any thread count, and runs stay reproducible and
+// shardable (different seeds + output files, then concatenate).
 // =============================================================================
 
 #include "chess/position.hpp"
@@ -20,13 +30,22 @@
 #include "chess/movelist.hpp"
 #include "chess/search.hpp"
 #include "chess/nnue.hpp"
+#include "chess/packed.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace chess;
@@ -42,10 +61,29 @@ bool is_capture(const Position& p, Move m) {
     return m.type_of() == EN_PASSANT || p.piece_on(m.to_sq()) != NO_PIECE;
 }
 
-// One self-play game. Appends "<fen>|<cp>" lines for quiet positions to `lines`
-// (cp is White-relative); returns the game result for White (1.0/0.5/0.0).
-double play_game(std::mt19937_64& rng, std::uint64_t nodes,
-                 std::vector<std::pair<std::string,int>>& lines) {
+// SplitMix64 over (seed, game index): an independent, well-mixed RNG seed per
+// game, so a game's moves depend only on its index - not on which thread plays
+// it or how many games that thread played before.
+std::uint64_t game_seed(std::uint64_t seed, std::uint64_t game) {
+    std::uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (game + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// A recorded quiet position. The packed record always carries score, best move
+// and ply; the FEN is only built for text output (castling/ep/clocks live there).
+struct Sample {
+    PackedBoard rec;
+    std::string fen;
+};
+
+// One self-play game. Appends the quiet positions to `samples` (scores White-
+// relative, result stamped by the caller); returns the game result for White
+// (1.0/0.5/0.0). `engine` belongs to the calling game loop - nothing here is
+// shared.
+double play_game(std::mt19937_64& rng, std::uint64_t nodes, bool binary,
+                 std::vector<Sample>& samples, SearchEngine& engine) {
     Position pos;
     pos.set_startpos();
     std::vector<std::uint64_t> hist = { pos.key() };
@@ -55,7 +93,6 @@ double play_game(std::mt19937_64& rng, std::uint64_t nodes,
     lim.max_nodes = nodes;
     lim.threads   = 1;
 
-    const std::size_t startIdx = lines.size();
     double result = 0.5;
     int decidedCount = 0, decidedSign = 0;
 
@@ -72,8 +109,7 @@ double play_game(std::mt19937_64& rng, std::uint64_t nodes,
         if (ply < RANDOM_PLIES) {                // random opening for diversity
             chosen = moves[std::uniform_int_distribution<int>(0, moves.size() - 1)(rng)];
         } else {
-            clear_stop();
-            SearchResult r = search(pos, lim, hist);
+            SearchResult r = engine.search(pos, lim, hist);
             chosen = r.best;
             if (chosen == MOVE_NONE) chosen = moves[0];
 
@@ -82,8 +118,11 @@ double play_game(std::mt19937_64& rng, std::uint64_t nodes,
             // Record only quiet positions: not in check, best move not a capture,
             // and a real centipawn score (skip mate scores - they aren't an eval
             // and would saturate the training sigmoid).
-            if (!pos.in_check() && !is_capture(pos, chosen) && std::abs(whiteCp) < 29000)
-                lines.emplace_back(pos.to_fen(), whiteCp);
+            if (!pos.in_check() && !is_capture(pos, chosen) && std::abs(whiteCp) < 29000) {
+                Sample& s = samples.emplace_back();
+                s.rec = PackedBoard::pack(pos, whiteCp, 0.5, chosen, ply);
+                if (!binary) s.fen = pos.to_fen();
+            }
 
             // Early adjudication when the score is lopsided for a few plies.
             int sign = (whiteCp > ADJ_WIN_CP) ? 1 : (whiteCp < -ADJ_WIN_CP ? -1 : 0);
@@ -96,31 +135,149 @@ double play_game(std::mt19937_64& rng, std::uint64_t nodes,
         pos.make_move(chosen, u);
         hist.push_back(pos.key());
     }
-
-    // Stamp the game result onto every position recorded this game (filled by
-    // the caller writing fen|cp|result).
-    (void)startIdx;
     return result;
 }
 
+// A finished game, already serialized (text lines or raw records) by the game
+// loop that played it, so formatting stays on the parallel side and the writer
+// only does I/O.
+struct GameOutput {
+    std::string   bytes;
+    std::uint64_t positions = 0;
+};
+
+// Shared between the game loops and the writer thread. Games are claimed by
+// index from `nextGame`; finished ones park in `done` until the writer reaches
+// their index (a reorder buffer - it stays small because games are handed out
+// in order).
+struct Shared {
+    int                            games = 0;
+    std::uint64_t                  nodes = 0;
+    std::uint64_t                  seed  = 0;
+    std::size_t                    hashMb = 2;
+    bool                           binary = false;
+    std::atomic<int>               nextGame{0};
+    std::atomic<std::uint64_t>     positions{0};   // live count, for the rate display
+    std::mutex                     mtx;
+    std::condition_variable        cv;
+    std::map<int, GameOutput>      done;
+};
+
+// One game loop (one per --threads). Owns its search engine (and so its TT).
+void game_loop(Shared& sh) {
+    SearchEngine engine(sh.hashMb);
+
+    for (int g; (g = sh.nextGame.fetch_add(1)) < sh.games; ) {
+        engine.clear();   // independent games: don't leak TT knowledge across them
+        std::mt19937_64 rng(game_seed(sh.seed, std::uint64_t(g)));
+        std::vector<Sample> samples;
+        double result = play_game(rng, sh.nodes, sh.binary, samples, engine);
+
+        GameOutput out;
+        if (sh.binary) {
+            out.bytes.resize(samples.size() * sizeof(PackedBoard));
+            char* p = out.bytes.data();
+            for (Sample& s : samples) {
+                s.rec.set_white_result(result);
+                std::memcpy(p, &s.rec, sizeof(PackedBoard));
+                p += sizeof(PackedBoard);
+            }
+        } else {
+            // Result as "1.0"/"0.5"/"0.0" (White-relative) - the form bullet's
+            // text loader expects.
+            const char* res = (result == 1.0) ? "1.0" : (result == 0.0) ? "0.0" : "0.5";
+            for (const Sample& s : samples)
+                out.bytes += s.fen + " | " + std::to_string(s.rec.white_score()) + " | " + res + "\n";
+        }
+        out.positions = samples.size();
+        sh.positions.fetch_add(out.positions, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lk(sh.mtx);
+            sh.done.emplace(g, std::move(out));
+        }
+        sh.cv.notify_one();
+    }
+}
+
+// The single writer: drains finished games in index order through one large
+// buffered stream, and prints live throughput about once a second.
+void writer_loop(Shared& sh, std::ofstream& f) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    auto lastReport  = start;
+
+    auto report = [&](int gamesDone) {
+        double secs = std::chrono::duration<double>(clock::now() - start).count();
+        std::uint64_t pos = sh.positions.load(std::memory_order_relaxed);
+        std::cerr << "\rgames " << gamesDone << "/" << sh.games
+                  << "  positions " << pos
+                  << "  " << std::uint64_t(secs > 0 ? pos / secs : 0) << " pos/s   " << std::flush;
+    };
+
+    for (int next = 0; next < sh.games; ) {
+        GameOutput out;
+        {
+            std::unique_lock<std::mutex> lk(sh.mtx);
+            sh.cv.wait_for(lk, std::chrono::seconds(1),
+                           [&] { return sh.done.count(next) != 0; });
+            auto it = sh.done.find(next);
+            if (it != sh.done.end()) {
+                out = std::move(it->second);
+                sh.done.erase(it);
+                ++next;
+            } else {
+                lk.unlock();
+                report(next);
+                lastReport = clock::now();
+                continue;
+            }
+        }
+        f.write(out.bytes.data(), std::streamsize(out.bytes.size()));
+        if (clock::now() - lastReport >= std::chrono::seconds(1) || next == sh.games) {
+            report(next);
+            lastReport = clock::now();
+        }
+    }
+    f.flush();
+}
+
 } // namespace
 
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "usage: gen_data <out.txt> [games=1000] [nodes=5000] [seed=1] [evalfile]\n"
-                     "  evalfile: optional NNUE net to LABEL with (bootstrapping). Omit = HCE.\n";
+    // Split --flags from the positional arguments (flags may appear anywhere).
+    std::vector<std::string> args;
+    int         threads = 1;
+    std::size_t hashMb  = 2;
+    bool        binary  = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--binary") { binary = true; continue; }
+        if      (a == "--threads" && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--hash"    && i + 1 < argc) hashMb  = std::size_t(std::max(1, std::atoi(argv[++i])));
+        else args.push_back(a);
+    }
+
+    if (args.empty()) {
+        std::cerr << "usage: gen_data <out> [games=1000] [nodes=5000] [seed=1] [evalfile]\n"
+                     "                [--threads N=1] [--hash MB=2] [--binary]\n"
+                     "  evalfile: optional NNUE net to LABEL with (bootstrapping). Omit = HCE.\n"
+                     "  --threads: parallel game loops in this process (output is identical for any N).\n"
+                     "  --hash: private transposition table per game loop, in MB.\n"
+                     "  --binary: write 32-byte bulletformat records instead of fen|cp|result text.\n";
         return 1;
     }
-    const std::string out = argv[1];
-    const int           games = (argc > 2) ? std::atoi(argv[2]) : 1000;
-    const std::uint64_t nodes = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 5000;
-    const std::uint64_t seed  = (argc > 4) ? std::strtoull(argv[4], nullptr, 10) : 1;
-    const std::string   evalfile = (argc > 5) ? argv[5] : "";
+    const std::string   out   = args[0];
+    const int           games = (args.size() > 1) ? std::atoi(args[1].c_str()) : 1000;
+    const std::uint64_t nodes = (args.size() > 2) ? std::strtoull(args[2].c_str(), nullptr, 10) : 5000;
+    const std::uint64_t seed  = (args.size() > 3) ? std::strtoull(args[3].c_str(), nullptr, 10) : 1;
+    const std::string   evalfile = (args.size() > 4) ? args[4] : "";
 
     // Bootstrapping: label with a previously-trained net instead of the HCE, so
     // each generation's targets come from a stronger teacher than the last. The
     // engine's evaluate() auto-uses NNUE once a net is loaded - generation code is
-    // unchanged; only the eval behind the search improves.
+    // unchanged; only the eval behind the search improves. The weights are shared
+    // read-only by every game loop (each Position carries its own accumulator).
     if (!evalfile.empty()) {
         if (!nnue::load(evalfile)) { std::cerr << "failed to load net: " << evalfile << "\n"; return 1; }
         std::cerr << "labeling with NNUE: " << evalfile << "\n";
@@ -128,29 +285,31 @@ int main(int argc, char** argv) {
         std::cerr << "labeling with HCE (no net)\n";
     }
 
-    std::ofstream f(out);
+    std::ofstream f;
+    std::vector<char> buf(std::size_t(1) << 20);            // 1 MB stream buffer
+    f.rdbuf()->pubsetbuf(buf.data(), std::streamsize(buf.size()));
+    f.open(out, binary ? std::ios::binary : std::ios::out);
     if (!f) { std::cerr << "cannot open " << out << "\n"; return 1; }
 
-    std::mt19937_64 rng(seed);
-    tt_clear();
-
-    std::uint64_t totalPositions = 0;
-    for (int g = 0; g < games; ++g) {
-        std::vector<std::pair<std::string,int>> lines;
-        double result = play_game(rng, nodes, lines);
-        // Result as "1.0"/"0.5"/"0.0" (White-relative) - the form bullet's text
-        // loader expects.
-        const char* res = (result == 1.0) ? "1.0" : (result == 0.0) ? "0.0" : "0.5";
-        for (auto& [fen, cp] : lines)
-            f << fen << " | " << cp << " | " << res << "\n";
-        totalPositions += lines.size();
-        tt_clear();   // independent games: don't leak TT knowledge across them
-
-        if ((g + 1) % 50 == 0 || g + 1 == games) {
-            std::cerr << "\rgames " << (g + 1) << "/" << games
-                      << "  positions " << totalPositions << std::flush;
-        }
-    }
-    std::cerr << "\ndone: " << totalPositions << " positions -> " << out << "\n";
+    Shared sh;
+    sh.games  = games;
+    sh.nodes  = nodes;
+    sh.seed   = seed;
+    sh.hashMb = hashMb;
+    sh.binary = binary;
+    threads   = std::min(threads, std::max(1, games));
+    std::cerr << "playing " << games << " games @ " << nodes << " nodes on "
+              << threads << " thread(s)\n";
+
+    std::vector<std::thread> loops;
+    loops.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+        loops.emplace_back(game_loop, std::ref(sh));
+    std::thread writer(writer_loop, std::ref(sh), std::ref(f));
+
+    for (auto& t : loops) t.join();
+    writer.join();
+
+    std::cerr << "\ndone: " << sh.positions.load() << " positions -> " << out << "\n";
     return 0;
 }
@@ -95,4 +95,12 @@ constexpr Bitboard north_west(Bitboard b) { return (b & ~FILE_A_BB) << 7; }
 constexpr Bitboard south_east(Bitboard b) { return (b & ~FILE_H_BB) >> 7; }
 constexpr Bitboard south_west(Bitboard b) { return (b & ~FILE_A_BB) >> 9; }
 
+// Mirror the board top-to-bottom (rank 1 <-> rank 8): square s -> s ^ 56. With
+// one byte per rank that is just a byte swap (compilers emit a single bswap).
+constexpr Bitboard flip_vertical(Bitboard b) {
+    b = ((b >>  8) & 0x00FF00FF00FF00FFULL) | ((b & 0x00FF00FF00FF00FFULL) <<  8);
+    b = ((b >> 16) & 0x0000FFFF0000FFFFULL) | ((b & 0x0000FFFF0000FFFFULL) << 16);
+    return (b >> 32) | (b << 32);
+}
+
 } // namespace chess
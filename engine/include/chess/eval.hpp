@@ -9,9 +9,56 @@
 // =============================================================================
 
 #include "chess/position.hpp"
+#include "chess/psqt.hpp"
+
+#include <algorithm>
 
 namespace chess {
 
+// Dispatches on the loaded backend: NNUE when a net is loaded, else the HCE.
 int evaluate(const Position& pos);
 
+// The hand-crafted evaluation, whatever net is loaded.
+int evaluate_hce(const Position& pos);
+
+// Evaluation policies for code that picks the backend once and is compiled per
+// backend (the search), so the hot path carries no is_loaded() branch and an
+// HCE search never touches the accumulator. LAZY_MARGIN bounds how far the
+// backend's eval can fall short of the material+PSQT estimate, measured over
+// positions three plies from a set of test positions (HCE: under 250 cp in
+// all of them; the NNUE: over 750 cp in about one in a thousand).
+struct HceEval {
+    static constexpr int LAZY_MARGIN = 250;
+    static int evaluate(const Position& pos) { return evaluate_hce(pos); }
+};
+
+struct NnueEval {   // requires nnue::is_loaded()
+    static constexpr int LAZY_MARGIN = 800;
+    static int evaluate(const Position& pos) {
+        return nnue::forward(pos.accumulator(), pos.side_to_move(),
+                             popcount(pos.pieces()));
+    }
+};
+
+// The cheap estimate: the material + piece-square sums Position keeps
+// incrementally, tapered by the game phase, from the side to move's
+// perspective. (The HCE is this plus its mobility and structure terms.)
+inline int psq_estimate(const Position& pos) {
+    const Color us    = pos.side_to_move();
+    const int   mg    = pos.psq_mg(us) - pos.psq_mg(~us);
+    const int   eg    = pos.psq_eg(us) - pos.psq_eg(~us);
+    const int   phase = std::min(pos.phase(), psqt::PHASE_MAX);
+    return (mg * phase + eg * (psqt::PHASE_MAX - phase)) / psqt::PHASE_MAX;
+}
+
+// Lazy evaluation: when the estimate is more than Eval::LAZY_MARGIN outside
+// [alpha, beta], the full eval would land outside the window too, so the
+// estimate is returned (and `lazy` set) without running the backend.
+template <class Eval>
+int evaluate_lazy(const Position& pos, int alpha, int beta, bool& lazy) {
+    const int est = psq_estimate(pos);
+    lazy = est >= beta + Eval::LAZY_MARGIN || est <= alpha - Eval::LAZY_MARGIN;
+    return lazy ? est : Eval::evaluate(pos);
+}
+
 } // namespace chess
@@ -0,0 +1,44 @@
+#pragma once
+// =============================================================================
+// chess/mapped_file.hpp - a read-only memory-mapped file.
+//
+// Maps a whole file into the address space (mmap / CreateFileMapping) so tools
+// can walk tens of GB of training records without reading them into RAM, and
+// so several processes reading the same file share one page-cached copy. Pages
+// fault in on first touch; nothing is copied.
+// =============================================================================
+
+#include <cstddef>
+#include <string>
+
+namespace chess {
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& o) noexcept { *this = static_cast<MappedFile&&>(o); }
+    MappedFile& operator=(MappedFile&& o) noexcept;
+
+    // Map `path` read-only (closing any previous mapping). An empty file opens
+    // successfully with size() == 0 and data() == nullptr.
+    bool open(const std::string& path);
+    void close();
+
+    bool                 is_open() const { return open_; }
+    const unsigned char* data()    const { return data_; }
+    std::size_t          size()    const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    std::size_t          size_ = 0;
+    bool                 open_ = false;
+#if defined(_WIN32)
+    void*                mapping_ = nullptr;   // HANDLE of the file mapping object
+#endif
+};
+
+} // namespace chess
@@ -2,7 +2,9 @@
 // =============================================================================
 // chess/movegen.hpp - legal move generation + perft.
 //
-// generate_legal fills a MoveList with every legal move for the side to move.
+// generate<Type> emits the pseudo-legal moves of one category; generate_legal
+// fills a MoveList with every legal move for the side to move (and
+// generate_legal<Type> with the legal moves of one category).
 // perft enumerates the move tree to a fixed depth (the correctness gate for the
 // generator: its node counts must match published reference values).
 //
@@ -16,7 +18,28 @@
 
 namespace chess {
 
-void generate_legal(Position& pos, MoveList& list);
+// What to generate, for the side to move:
+//   CAPTURES      captures, en passant and ALL promotions (the "noisy" moves)
+//   QUIETS        everything else: quiet piece moves, pawn pushes, castling
+//   QUIET_CHECKS  the QUIETS that give check, directly or by discovery (castling
+//                 excluded)
+//   EVASIONS      while in check: king moves, plus (single check) captures of
+//                 the checker and interpositions on its ray
+//   ALL           CAPTURES + QUIETS
+// Every type emits its moves in the same relative order as ALL.
+enum GenType { CAPTURES, QUIETS, QUIET_CHECKS, EVASIONS, ALL };
+
+// Pseudo-legal moves (may leave the own king in check). `Us` must be the side
+// to move; the one-parameter form dispatches on it. Every color-dependent
+// constant (pawn direction, start/promotion ranks, castling squares) is a
+// compile-time constant in each instantiation.
+template <Color Us, GenType Type> void generate(const Position& pos, MoveList& list);
+template <GenType Type>           void generate(const Position& pos, MoveList& list);
+
+// Legal moves of one category.
+template <GenType Type> void generate_legal(Position& pos, MoveList& list);
+
+void generate_legal(Position& pos, MoveList& list);   // = generate_legal<ALL>
 
 // Legal "noisy" moves only: captures, en passant and promotions (the quiescence
 // search's move set). Produces the same moves generate_legal would, restricted to
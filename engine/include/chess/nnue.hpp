@@ -30,6 +30,7 @@ constexpr int PIECE_KINDS = 6;                       // PAWN..KING
 constexpr int SQUARES     = 64;
 constexpr int INPUT_DIM   = COLORS * PIECE_KINDS * SQUARES;  // 768
 constexpr int L1          = 256;                     // accumulator size per perspective
+constexpr int MAX_OUTPUT_BUCKETS = 8;                // output layers chosen by piece count
 
 // ---- Feature indexing (pure, implemented now) -------------------------------
 // The index of the "this piece is on this square" feature, as seen from one
@@ -58,7 +59,12 @@ struct alignas(32) Accumulator {   // 32-byte aligned for AVX2 loads/stores
 // Wire to a UCI `EvalFile` option. While unloaded, evaluate() must fall back to HCE.
 bool load(const std::string& path);
 bool is_loaded();
-void unload();   // drop the loaded net (evaluate() falls back to HCE)
+void unload();          // drop the loaded net (evaluate() falls back to HCE)
+int  output_buckets();  // the loaded net's output bucket count (1 = unbucketed)
+
+// Write the loaded network to `path` in the file layout (bullet's, with the
+// load-time weight permutation undone). False if none is loaded or on I/O error.
+bool save(const std::string& path);
 
 // Load the network compiled into the binary (tools/embed_net.py -> embedded_net.cpp).
 // Lets the engine use NNUE with no external file. Returns false if no net is embedded.
@@ -70,7 +76,8 @@ void refresh(Accumulator& acc, const Position& pos);
 
 // Run the quantized forward pass from a (valid) accumulator and return the eval in
 // centipawns from `stm`'s perspective (same convention as the HCE evaluate()).
-int forward(const Accumulator& acc, Color stm);
+// `pieceCount` (kings included) selects the output bucket.
+int forward(const Accumulator& acc, Color stm, int pieceCount);
 
 // ---- Incremental updates (Phase 2) ------------------------------------------
 // Called from Position::put_piece / remove_piece so the accumulator tracks the
@@ -87,7 +94,13 @@ bool accumulator_matches_refresh(const Accumulator& acc, const Position& pos);
 
 // Test/bootstrap helper: install a small deterministic in-memory network (so the
 // incremental==refresh gate can run without a trained net file). Not for play.
-void make_random_net(unsigned seed);
+void make_random_net(unsigned seed, int buckets = 1);
+
+// Test helper: the L1 neuron order later loads bring the weights into
+// (`order[i]` = the file neuron kept at position i; L1 entries, a permutation),
+// or nullptr for the kernels' own. The kernels don't depend on it, so any
+// order must evaluate the same and save() must still write the file order.
+void set_neuron_order(const std::uint16_t* order);
 
 } // namespace nnue
 } // namespace chess
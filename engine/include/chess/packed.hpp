@@ -0,0 +1,94 @@
+#pragma once
+// =============================================================================
+// chess/packed.hpp - 32-byte packed training records (bulletformat ChessBoard).
+//
+// The binary form of gen_data's `fen | cp | result` lines. The layout is
+// bullet's `ChessBoard` byte for byte, so a file of these records IS bullet's
+// training input (no conversion pass):
+//
+//   occ      u64      occupancy, from the SIDE TO MOVE's view: with black to
+//                     move the board is flipped vertically (byte-swapped) and
+//                     the colours swapped, so the mover is always "white"
+//   pcs      u8[16]   one nibble per occupied square, in occ's LSB-first order:
+//                     (isOpponent << 3) | (pieceType - 1)
+//   score    i16      centipawns, side-to-move relative
+//   result   u8       side-to-move relative: 0 loss, 1 draw, 2 win
+//   ksq      u8       mover's king square (flipped view)
+//   oppKsq   u8       opponent's king square (flipped view) ^ 56
+//   extra    u8[3]    ignored by bullet; we keep our metadata here:
+//                       extra[0..1] (u16 LE) bits 0..13 = best move from/to/promo
+//                                   (flipped view; type re-derived on decode),
+//                                   bit 15 = black to move in the real game
+//                       extra[2]    game ply (saturates at 255)
+//
+// Castling rights, en passant and the move clocks are NOT stored (bullet never
+// reads them). Records are written in host byte order - little-endian on every
+// platform we build for, which is what bullet expects.
+// =============================================================================
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "chess/types.hpp"
+#include "chess/move.hpp"
+#include "chess/position.hpp"
+
+namespace chess {
+
+struct PackedBoard {
+    std::uint64_t occ    = 0;
+    std::uint8_t  pcs[16] = {};
+    std::int16_t  score  = 0;
+    std::uint8_t  result = 1;
+    std::uint8_t  ksq    = 0;
+    std::uint8_t  oppKsq = 0;
+    std::uint8_t  extra[3] = {};
+
+    // Pack `pos`. `whiteScore` and `whiteResult` (1.0 / 0.5 / 0.0) are White-
+    // relative, like the text format; `best` is the move played from `pos` (or
+    // MOVE_NONE) and `ply` the game ply (-1 = derive it from the move counters).
+    static PackedBoard pack(const Position& pos, int whiteScore, double whiteResult,
+                            Move best = MOVE_NONE, int ply = -1);
+
+    // Stamp the game outcome (White-relative) onto a record packed mid-game.
+    void set_white_result(double whiteResult);
+
+    // Rebuild the real (un-flipped) position. No castling / en passant, clocks 0/1.
+    void unpack(Position& pos) const;
+
+    Color  side_to_move() const { return (extra[1] & 0x80) ? BLACK : WHITE; }
+    int    ply()          const { return extra[2]; }
+    int    white_score()  const { return side_to_move() == WHITE ? score : -score; }
+    double white_result() const {
+        int r = side_to_move() == WHITE ? result : 2 - result;
+        return r * 0.5;
+    }
+
+    // The recorded best move in real coordinates, with its type (castling, en
+    // passant, promotion) re-derived from `pos`, which must be this record's
+    // unpack(). MOVE_NONE if none was recorded.
+    Move best_move(const Position& pos) const;
+};
+
+static_assert(sizeof(PackedBoard) == 32, "PackedBoard must match bulletformat's 32-byte ChessBoard");
+
+// Parse one `fen | cp | result` line (gen_data's text format; result tokens
+// "1"/"1.0", "0"/"0.0", anything else = draw). Returns false on a malformed line.
+bool parse_text_record(const std::string& line, PackedBoard& out);
+
+// Sequential buffered reader over a file of PackedBoard records.
+class PackedReader {
+public:
+    bool open(const std::string& path);
+
+    // Read up to `max` records into `out`; returns how many (0 at end of file).
+    std::size_t read(PackedBoard* out, std::size_t max);
+
+private:
+    std::ifstream f_;
+};
+
+} // namespace chess
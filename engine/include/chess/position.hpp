@@ -31,6 +31,12 @@ public:
     void set_startpos();  // standard chess starting position
     void set_fen(const std::string& fen);  // load a position from a FEN string
 
+    // Finish a board assembled with reset() + put_piece(): set the non-piece
+    // state and fold it into the key, exactly as set_fen does. Used to rebuild
+    // positions from packed training records (chess/packed.hpp).
+    void set_state(Color stm, int castling = NO_CASTLING, Square ep = SQ_NONE,
+                   int halfmove = 0, int fullmove = 1);
+
     // The piece sitting on square s (NO_PIECE if empty).
     Piece piece_on(Square s) const {
         return board_[s];
@@ -102,6 +108,13 @@ public:
     void put_piece(Piece pc, Square s);   // place pc on s (s must be empty)
     void remove_piece(Square s);          // remove whatever is on s
 
+    // Material + piece-square sums of color c's pieces, midgame and endgame
+    // (chess/psqt.hpp), and the game phase (psqt::PHASE_W summed over the board,
+    // uncapped). Maintained incrementally by put_piece/remove_piece, like the key.
+    int psq_mg(Color c) const { return psqMg_[c]; }
+    int psq_eg(Color c) const { return psqEg_[c]; }
+    int phase() const         { return phase_; }
+
     // ---- NNUE accumulator (per-position hidden state) ----
     // Maintained incrementally by put_piece/remove_piece (like the Zobrist key)
     // while it is valid. Lazily refreshed here on first use, then it rides along
@@ -111,6 +124,10 @@ public:
         if (!acc_.valid) nnue::refresh(acc_, *this);
         return acc_;
     }
+    // Drop the accumulator (it refreshes on next use). A search invalidates its
+    // root copy: an NNUE search then builds it from the current net, and an HCE
+    // search's board edits skip the incremental updates entirely.
+    void invalidate_accumulator() { acc_.valid = false; }
 
     // ---- debug / serialization (provided in position.cpp) ----
     std::string to_string() const;        // ASCII board, rank 8 on top
@@ -126,6 +143,9 @@ private:
     int      halfmoveClock_          = 0;
     int      fullmoveNumber_         = 1;
     std::uint64_t key_               = 0;   // zobrist hash; see key()
+    int      psqMg_[COLOR_NB]        = {};  // see psq_mg()
+    int      psqEg_[COLOR_NB]        = {};
+    int      phase_                  = 0;
 
     // NNUE accumulator. `mutable` so the const accessor can lazily refresh it.
     // Default-constructed as invalid (valid=false) => refreshed on first use.
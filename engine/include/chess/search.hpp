@@ -7,44 +7,178 @@
 // late move reductions and aspiration windows. See search.cpp.
 // =============================================================================
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 #include "chess/position.hpp"
 #include "chess/move.hpp"
+#include "chess/tt.hpp"
 
 namespace chess {
 
+struct ThreadPool;   // search.cpp: the engine's long-lived search threads
+
 struct SearchLimits {
     int           depth      = 64;  // max iterative-deepening depth
     int           movetime_ms = 0;  // wall-clock budget in ms (0 = no time limit)
-    std::uint64_t max_nodes   = 0;  // node budget (0 = no node limit)
+    std::uint64_t max_nodes   = 0;  // node budget over all threads (0 = no node limit)
     int           threads     = 1;  // Lazy SMP: number of parallel search threads
+                                    // (the engine's pool is resized if it differs)
+    int           multipv     = 1;  // number of best lines to search and report
+    bool          ponder      = false;  // start on the opponent's clock: movetime_ms
+                                        // only counts from SearchEngine::ponderhit()
 };
 
 struct SearchResult {
     Move          best  = MOVE_NONE;  // best move found
     int           score = 0;          // centipawns, side-to-move perspective
     int           depth = 0;          // last fully completed depth
-    std::uint64_t nodes = 0;          // nodes visited
+    std::uint64_t nodes = 0;          // nodes visited by all threads
+    std::uint64_t evals = 0;          // static evals run by the backend, all threads
+    std::uint64_t lazyEvals = 0;      // ...and answered by the lazy estimate instead
+    std::vector<Move> pv;             // principal variation, starting with `best`
+};
+
+// One line of progress output (UCI `info`), reported by the main search thread
+// while it searches:
+//   LINE      a completed line after each depth (one per MultiPV line, best
+//             first), or an aspiration fail-high / fail-low (bound LOWER/UPPER)
+//             just before the re-search
+//   CURRMOVE  the root move being searched, on iterations running > 3 s
+//   PROGRESS  about once a second: nodes / nps / hashfull / time
+// `nodes` is the total over all Lazy SMP threads.
+struct SearchInfo {
+    enum Kind : std::uint8_t { LINE, CURRMOVE, PROGRESS };
+
+    Kind          kind     = LINE;
+    int           depth    = 0;
+    int           seldepth = 0;           // deepest ply reached this iteration
+    int           multipv  = 1;           // LINE: 1-based line number
+    int           score    = 0;           // LINE: centipawns, side-to-move perspective
+    Bound         bound    = BOUND_EXACT; // LINE: LOWER = fail high, UPPER = fail low
+    std::uint64_t nodes    = 0;
+    std::int64_t  time_ms  = 0;           // since the search started
+    int           hashfull = 0;           // TT occupancy, permille
+    Move          currmove = MOVE_NONE;   // CURRMOVE
+    int           currmovenumber = 0;     // CURRMOVE: 1-based
+    std::vector<Move> pv;                 // LINE: the line, starting with its root move
+
+    std::uint64_t nps() const { return nodes * 1000 / std::uint64_t(std::max<std::int64_t>(1, time_ms)); }
+};
+
+// A self-contained searcher: its own transposition table, abort flag, per-
+// search limits and pool of search threads. Instances are fully independent, so
+// one process can run many games or analyses side by side (gen_data --threads
+// gives each game loop its own engine); they share only read-only globals
+// (attack tables, NNUE weights). One search at a time per instance; stop() may
+// be called from any thread.
+//
+// The threads are created once (set_threads) and sleep between searches, so a
+// `go` costs a wake-up rather than a thread spawn + join.
+class SearchEngine {
+public:
+    explicit SearchEngine(std::size_t hashMb = 16);   // 16 MB = UCI Hash default
+    ~SearchEngine();
+
+    SearchEngine(const SearchEngine&)            = delete;
+    SearchEngine& operator=(const SearchEngine&) = delete;
+
+    // Search `pos` under `limits` and return the best move. `pos` is left
+    // unchanged. `history` is the Zobrist keys of every position in the game so
+    // far (its last element must be pos.key()); it lets the search score
+    // repetitions as draws. Does NOT clear the stop flag (see clear_stop) and
+    // does NOT clear the TT - entries are validated by key, so they are reused
+    // across moves within a game. (The entries also hold static evals, so the
+    // TT is cleared when the evaluation backend differs from the last search's.)
+    SearchResult search(Position& pos, const SearchLimits& limits,
+                        const std::vector<std::uint64_t>& history = {});
+
+    // The same search, asynchronously: returns at once and runs on the pool.
+    // `onDone` is called with the result on the search thread when it ends
+    // (naturally or via stop()); `onInfo` with each completed depth's lines.
+    // `pos` and `history` are copied.
+    void start(const Position& pos, const SearchLimits& limits,
+               const std::vector<std::uint64_t>& history,
+               std::function<void(const SearchResult&)> onDone = {},
+               std::function<void(const SearchInfo&)> onInfo = {});
+
+    // Block until the current search (if any) has finished and reported.
+    void wait();
+
+    // The opponent played the move we pondered on: the running ponder search
+    // becomes a normal timed one, keeping everything searched so far, with its
+    // movetime budget counted from now. (stop() instead ends it - the caller
+    // ignores its result.) Ignored unless a ponder search is running.
+    void ponderhit();
+
+    // (Re)create the pool with `n` threads (waits for a running search first).
+    // With `pin`, thread i is bound to logical CPU i. UCI Threads option.
+    void set_threads(int n, bool pin = false);
+
+    // Ask the running search to abort as soon as possible (thread-safe). The
+    // search returns its best result so far.
+    void stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    // Clear the abort flag. MUST be called (on the controlling thread) before
+    // starting a search that should run to completion - do NOT clear it from
+    // inside the search thread, or a stop() that arrives just after launch
+    // could be lost.
+    void clear_stop() { stop_.store(false, std::memory_order_relaxed); }
+
+    // Forget everything learned so far (new game): empties the TT and resets
+    // every thread's move-ordering tables (history, killers, counter-moves),
+    // which are otherwise carried from one search to the next.
+    void clear();
+
+    // Resize the transposition table to `mb` megabytes (clears it).
+    void resize_tt(std::size_t mb);
+
+    // The table itself, for inspection between searches (tests, tools). Never
+    // touch it while a search is running.
+    TranspositionTable& tt() { return tt_; }
+
+private:
+    TranspositionTable          tt_;
+    std::atomic<bool>           stop_{false};   // external abort + helper halt
+    SearchLimits                limits_;        // the running search's limits (copied in)
+    std::vector<std::uint64_t>  history_;       // ...and its game history
+    std::function<void(const SearchInfo&)> onInfo_;   // ...and its progress callback
+    SearchResult                result_;        // the last search's result
+    bool                        pin_ = false;
+    bool                        ttNnue_ = false;   // backend whose evals the TT holds
+    std::atomic<bool>           pondering_{false};
+    std::atomic<std::int64_t>   ponderhitMs_{0};   // ponderhit time, ms into the search
+    std::chrono::steady_clock::time_point startTime_;
+    std::unique_ptr<ThreadPool> pool_;          // last: its threads use the members above
 };
 
-// Search `pos` under `limits` and return the best move. `pos` is left unchanged.
-// `history` is the Zobrist keys of every position in the game so far (its last
-// element must be pos.key()); it lets the search score repetitions as draws.
+// Static Exchange Evaluation: does the capture `m` win at least `threshold`
+// centipawns (P 100, N 320, B 330, R 500, Q 900) once every profitable
+// recapture on its square is played out? Move ordering and quiescence pruning
+// use it; a non-capture is worth 0.
+bool see_ge(const Position& pos, Move m, int threshold);
+
+// ---- Process-wide engine ---------------------------------------------------
+// The functions below drive one default SearchEngine instance (the UCI loop's).
+
+// Search `pos` with the default engine; see SearchEngine::search.
 SearchResult search(Position& pos, const SearchLimits& limits,
                     const std::vector<std::uint64_t>& history = {});
 
-// Ask the running search to abort as soon as possible (thread-safe). The search
-// returns its best result so far. Used to implement UCI `stop` / start-over.
+// Ask the running search to abort as soon as possible (thread-safe). Used to
+// implement UCI `stop` / start-over.
 void stop_search();
 
-// Clear the abort flag. MUST be called (on the controlling thread) before
-// starting a search that should run to completion - do NOT clear it from inside
-// the search thread, or a `stop` that arrives just after launch could be lost.
+// Clear the abort flag before starting a search; see SearchEngine::clear_stop.
 void clear_stop();
 
-// Empty the transposition table. Call on a new game (the TT is otherwise kept
-// across moves, since entries are validated by key).
+// Forget the previous game (SearchEngine::clear): empties the transposition
+// table and the move-ordering tables, both otherwise kept across moves.
 void tt_clear();
 
 // Resize the transposition table to `mb` megabytes (clears it). UCI Hash option.
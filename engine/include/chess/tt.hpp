@@ -0,0 +1,80 @@
+#pragma once
+// =============================================================================
+// chess/tt.hpp - the transposition table.
+//
+// The ONE component the search shares between threads. Lockless: entries are
+// validated by the full key, so a torn concurrent write just looks like a miss.
+// Each SearchEngine (chess/search.hpp) owns one; independent engines never share
+// a table.
+// =============================================================================
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "chess/move.hpp"
+
+namespace chess {
+
+enum Bound : std::uint8_t { BOUND_NONE, BOUND_EXACT, BOUND_LOWER, BOUND_UPPER };
+
+struct TTEntry {
+    std::uint64_t key   = 0;
+    Move          move  = MOVE_NONE;
+    std::int16_t  score = 0;
+    std::int8_t   depth = 0;
+    std::uint8_t  bound = BOUND_NONE;
+    std::int16_t  eval  = 0;            // static eval of the position (side to move)
+};
+static_assert(sizeof(TTEntry) == 16, "TTEntry must stay 16 bytes");
+
+// One bucket per key (always-replace). Reads are validated by the full key, so a
+// torn concurrent write just looks like a miss or is caught by the key check -
+// acceptable for Lazy SMP.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(std::size_t mb = 16) { resize(mb); }   // 16 MB = UCI Hash default
+
+    // (Re)allocate to the largest power-of-two entry count fitting in `mb`
+    // megabytes, and clear. A bigger table = fewer collisions, which matters more
+    // the deeper / more-threaded the search (many threads hammering one TT).
+    void resize(std::size_t mb) {
+        std::size_t n = (mb * 1024 * 1024) / sizeof(TTEntry);
+        std::size_t p = 1;
+        while ((p << 1) <= n) p <<= 1;     // round down to a power of two
+        table_.assign(p, TTEntry{});
+        mask_ = table_.size() - 1;
+    }
+
+    void clear() { std::fill(table_.begin(), table_.end(), TTEntry{}); }
+
+    // Occupancy in permille (UCI `hashfull`), sampled from the first 1000 slots.
+    // There is no generation counter, so entries left by earlier searches count
+    // as used.
+    int hashfull() const {
+        const std::size_t n = std::min<std::size_t>(1000, table_.size());
+        std::size_t used = 0;
+        for (std::size_t i = 0; i < n; ++i) used += (table_[i].key != 0);
+        return int(used * 1000 / n);
+    }
+
+    TTEntry* probe(std::uint64_t key, bool& hit) {
+        TTEntry* e = &table_[key & mask_];
+        hit = (e->key == key);
+        return e;
+    }
+
+    // Pull the bucket into cache ahead of the probe (hardware prefetch).
+    void prefetch(std::uint64_t key) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&table_[key & mask_]);
+#endif
+    }
+
+private:
+    std::vector<TTEntry> table_;
+    std::size_t          mask_ = 0;
+};
+
+} // namespace chess
@@ -0,0 +1,90 @@
+#include "chess/mapped_file.hpp"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chess {
+
+MappedFile& MappedFile::operator=(MappedFile&& o) noexcept {
+    if (this != &o) {
+        close();
+        data_ = o.data_;  size_ = o.size_;  open_ = o.open_;
+#if defined(_WIN32)
+        mapping_ = o.mapping_;  o.mapping_ = nullptr;
+#endif
+        o.data_ = nullptr;  o.size_ = 0;  o.open_ = false;
+    }
+    return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(file, &sz)) { CloseHandle(file); return false; }
+    size_ = static_cast<std::size_t>(sz.QuadPart);
+    if (size_ == 0) { CloseHandle(file); open_ = true; return true; }
+
+    // The mapping object keeps the file alive; the file handle can go now.
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) { size_ = 0; return false; }
+    void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!p) { CloseHandle(mapping); size_ = 0; return false; }
+
+    mapping_ = mapping;
+    data_    = static_cast<const unsigned char*>(p);
+    open_    = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_)    UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(static_cast<HANDLE>(mapping_));
+    data_ = nullptr;  mapping_ = nullptr;  size_ = 0;  open_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0) { ::close(fd); open_ = true; return true; }
+
+    // The mapping holds its own reference to the file; the descriptor can go now.
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { size_ = 0; return false; }
+
+    data_ = static_cast<const unsigned char*>(p);
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+    data_ = nullptr;  size_ = 0;  open_ = false;
+}
+
+#endif
+
+} // namespace chess
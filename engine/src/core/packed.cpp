@@ -0,0 +1,136 @@
+#include "chess/packed.hpp"
+#include "chess/bitboard.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace chess {
+namespace {
+
+// A square as seen from the packed record's side-to-move view.
+Square view_sq(Square s, bool flip) { return flip ? Square(s ^ 56) : s; }
+
+std::string trim(const std::string& s) {
+    const char* ws = " \t\r\n";
+    std::size_t b = s.find_first_not_of(ws);
+    if (b == std::string::npos) return "";
+    std::size_t e = s.find_last_not_of(ws);
+    return s.substr(b, e - b + 1);
+}
+
+} // namespace
+
+PackedBoard PackedBoard::pack(const Position& pos, int whiteScore, double whiteResult,
+                              Move best, int ply) {
+    const Color stm  = pos.side_to_move();
+    const bool  flip = (stm == BLACK);
+    PackedBoard b;
+
+    // Occupancy + one nibble per piece, walked in the flipped view's LSB order.
+    b.occ = flip ? flip_vertical(pos.pieces()) : pos.pieces();
+    Bitboard occ = b.occ;
+    for (int idx = 0; occ; ++idx) {
+        const Square vs = pop_lsb(occ);
+        const Piece  pc = pos.piece_on(view_sq(vs, flip));
+        const int nibble = ((color_of(pc) != stm) << 3) | (type_of(pc) - 1);
+        b.pcs[idx / 2] |= std::uint8_t(nibble << (4 * (idx & 1)));
+    }
+
+    const int cp = std::clamp(whiteScore, -32767, 32767);
+    b.score  = std::int16_t(flip ? -cp : cp);
+    b.ksq    = std::uint8_t(view_sq(pos.king_square(stm), flip));
+    b.oppKsq = std::uint8_t(view_sq(pos.king_square(~stm), flip) ^ 56);
+
+    std::uint16_t meta = flip ? 0x8000 : 0;
+    if (best != MOVE_NONE) {
+        const PieceType promo = best.type_of() == PROMOTION ? best.promotion_type() : KNIGHT;
+        meta |= Move::make(view_sq(best.from_sq(), flip), view_sq(best.to_sq(), flip),
+                           NORMAL, promo).raw() & 0x3FFF;
+    }
+    if (ply < 0) ply = 2 * (pos.fullmove_number() - 1) + (stm == BLACK);
+    b.extra[0] = std::uint8_t(meta & 0xFF);
+    b.extra[1] = std::uint8_t(meta >> 8);
+    b.extra[2] = std::uint8_t(std::clamp(ply, 0, 255));
+    b.set_white_result(whiteResult);
+    return b;
+}
+
+void PackedBoard::set_white_result(double whiteResult) {
+    const int r = int(std::lround(whiteResult * 2));   // 0 / 1 / 2, White-relative
+    result = std::uint8_t(side_to_move() == WHITE ? r : 2 - r);
+}
+
+void PackedBoard::unpack(Position& pos) const {
+    const Color stm  = side_to_move();
+    const bool  flip = (stm == BLACK);
+
+    pos.reset();
+    Bitboard o = occ;
+    for (int idx = 0; o; ++idx) {
+        const Square vs     = pop_lsb(o);
+        const int    nibble = (pcs[idx / 2] >> (4 * (idx & 1))) & 0xF;
+        const Color  c      = (nibble & 8) ? ~stm : stm;
+        pos.put_piece(make_piece(c, PieceType((nibble & 7) + 1)), view_sq(vs, flip));
+    }
+    pos.set_state(stm);
+}
+
+Move PackedBoard::best_move(const Position& pos) const {
+    const std::uint16_t bits = std::uint16_t((extra[0] | (extra[1] << 8)) & 0x3FFF);
+    if ((bits & 0xFFF) == 0) return MOVE_NONE;   // from == to == a1: nothing recorded
+
+    const bool   flip = (side_to_move() == BLACK);
+    const Move   raw(bits);
+    const Square from = view_sq(raw.from_sq(), flip);
+    const Square to   = view_sq(raw.to_sq(), flip);
+    const PieceType pt = type_of(pos.piece_on(from));
+
+    if (pt == KING && std::abs(int(file_of(to)) - int(file_of(from))) == 2)
+        return Move::make(from, to, CASTLING);
+    if (pt == PAWN) {
+        if (rank_of(to) == RANK_8 || rank_of(to) == RANK_1)
+            return Move::make(from, to, PROMOTION, raw.promotion_type());
+        if (file_of(to) != file_of(from) && pos.empty(to))
+            return Move::make(from, to, EN_PASSANT);
+    }
+    return Move::make(from, to);
+}
+
+bool parse_text_record(const std::string& line, PackedBoard& out) {
+    const std::size_t a = line.find('|');
+    const std::size_t b = line.rfind('|');
+    if (a == std::string::npos || a == b) return false;
+
+    const std::string fen = trim(line.substr(0, a));
+    const std::string cp  = trim(line.substr(a + 1, b - a - 1));
+    const std::string res = trim(line.substr(b + 1));
+
+    char* end = nullptr;
+    const long score = std::strtol(cp.c_str(), &end, 10);
+    if (cp.empty() || *end != '\0') return false;
+
+    const double result = (res == "1" || res == "1.0") ? 1.0
+                        : (res == "0" || res == "0.0") ? 0.0 : 0.5;
+
+    Position pos;
+    pos.set_fen(fen);
+    if (popcount(pos.pieces(WHITE, KING)) != 1 || popcount(pos.pieces(BLACK, KING)) != 1
+        || popcount(pos.pieces()) > 32)
+        return false;
+    out = PackedBoard::pack(pos, int(score), result);
+    return true;
+}
+
+bool PackedReader::open(const std::string& path) {
+    f_.open(path, std::ios::binary);
+    return bool(f_);
+}
+
+std::size_t PackedReader::read(PackedBoard* out, std::size_t max) {
+    if (!f_) return 0;
+    f_.read(reinterpret_cast<char*>(out), std::streamsize(max * sizeof(PackedBoard)));
+    return std::size_t(f_.gcount()) / sizeof(PackedBoard);
+}
+
+} // namespace chess
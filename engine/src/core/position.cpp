@@ -1,5 +1,6 @@
 #include "chess/position.hpp"
 #include "chess/attacks.hpp"
+#include "chess/psqt.hpp"
 
 #include <cctype>
 #include <cstdint>
@@ -88,7 +89,8 @@ void Position::reset() {
 // -----------------------------------------------------------------------------
 // put_piece / remove_piece - the ONLY places that touch the raw arrays. Both
 // representations (bitboards + mailbox) must stay in sync, so each edit updates
-// all three. Everything else in the engine goes through these two.
+// all three, plus the incremental key, PSQT sums, phase and NNUE accumulator.
+// Everything else in the engine goes through these two.
 // -----------------------------------------------------------------------------
 
 void Position::put_piece(Piece pc, Square s) {
@@ -96,20 +98,29 @@ void Position::put_piece(Piece pc, Square s) {
     set(byColor_[color_of(pc)], s);
     set(byType_[type_of(pc)], s);
     key_ ^= Z.piece[pc][s];
+    psqMg_[color_of(pc)] += psqt::mg_value(pc, s);
+    psqEg_[color_of(pc)] += psqt::eg_value(pc, s);
+    phase_               += psqt::PHASE_W[type_of(pc)];
     // Keep the NNUE accumulator in sync IF it is already valid (like the key).
-    // If invalid (fresh board / FEN rebuild / no net), leave it - it refreshes
-    // lazily on first use, so bulk edits and the HCE path cost nothing here.
-    if (acc_.valid && nnue::is_loaded())
+    // If invalid (fresh board / FEN rebuild / HCE search), leave it - it
+    // refreshes lazily on first use, so bulk edits and the HCE path cost nothing
+    // here. (Only an NNUE evaluation makes it valid, and it indexes the loaded
+    // weights: load() unmaps or frees the previous net's, so a net may only be
+    // swapped while no search is running - the UCI front-end stops it first.)
+    if (acc_.valid)
         nnue::add_piece(acc_, color_of(pc), type_of(pc), s);
 }
 
 void Position::remove_piece(Square s) {
     Piece pc = board_[s];
     key_ ^= Z.piece[pc][s];
+    psqMg_[color_of(pc)] -= psqt::mg_value(pc, s);
+    psqEg_[color_of(pc)] -= psqt::eg_value(pc, s);
+    phase_               -= psqt::PHASE_W[type_of(pc)];
     clear(byColor_[color_of(pc)], s);
     clear(byType_[type_of(pc)], s);
     board_[s] = NO_PIECE;
-    if (acc_.valid && nnue::is_loaded())
+    if (acc_.valid)
         nnue::remove_piece(acc_, color_of(pc), type_of(pc), s);
 }
 
@@ -306,11 +317,15 @@ void Position::set_startpos() {
         put_piece(make_piece(BLACK, PAWN),    make_square(f, RANK_7));
         put_piece(make_piece(BLACK, back[f]), make_square(f, RANK_8));
     }
-    sideToMove_     = WHITE;
-    castlingRights_ = ANY_CASTLING;
-    epSquare_       = SQ_NONE;
-    halfmoveClock_  = 0;
-    fullmoveNumber_ = 1;
+    set_state(WHITE, ANY_CASTLING);
+}
+
+void Position::set_state(Color stm, int castling, Square ep, int halfmove, int fullmove) {
+    sideToMove_     = stm;
+    castlingRights_ = castling;
+    epSquare_       = ep;
+    halfmoveClock_  = halfmove;
+    fullmoveNumber_ = fullmove;
 
     // Fold the non-piece state into the key (piece keys were added by put_piece).
     if (sideToMove_ == BLACK) key_ ^= Z.side;
@@ -346,33 +361,26 @@ void Position::set_fen(const std::string& fen) {
         }
     }
 
-    // Field 2: side to move.
-    sideToMove_ = (stm == "w") ? WHITE : BLACK;
-
     // Field 3: castling rights (any subset of KQkq, or "-").
+    int rights = NO_CASTLING;
     if (castling != "-") {
         for (char ch : castling) {
             switch (ch) {
-                case 'K': castlingRights_ |= WHITE_OO;  break;
-                case 'Q': castlingRights_ |= WHITE_OOO; break;
-                case 'k': castlingRights_ |= BLACK_OO;  break;
-                case 'q': castlingRights_ |= BLACK_OOO; break;
+                case 'K': rights |= WHITE_OO;  break;
+                case 'Q': rights |= WHITE_OOO; break;
+                case 'k': rights |= BLACK_OO;  break;
+                case 'q': rights |= BLACK_OOO; break;
             }
         }
     }
 
     // Field 4: en-passant target square (algebraic like "e3", or "-").
+    Square epSq = SQ_NONE;
     if (ep != "-")
-        epSquare_ = make_square(File(ep[0] - 'a'), Rank(ep[1] - '1'));
-
-    // Fields 5 & 6: move clocks.
-    halfmoveClock_  = half;
-    fullmoveNumber_ = full;
+        epSq = make_square(File(ep[0] - 'a'), Rank(ep[1] - '1'));
 
-    // Fold the non-piece state into the key (piece keys were added by put_piece).
-    if (sideToMove_ == BLACK) key_ ^= Z.side;
-    key_ ^= Z.castling[castlingRights_];
-    if (epSquare_ != SQ_NONE) key_ ^= Z.epFile[file_of(epSquare_)];
+    // Field 2 (side to move) and fields 5 & 6 (move clocks) go straight in.
+    set_state(stm == "w" ? WHITE : BLACK, rights, epSq, half, full);
 }
 
 // -----------------------------------------------------------------------------
@@ -7,7 +7,7 @@ namespace chess { namespace nnue {
 extern const unsigned char EMBEDDED_NET[394816];
 extern const std::size_t   EMBEDDED_NET_SIZE = 394816;
 
-const unsigned char EMBEDDED_NET[394816] = {
+alignas(64) const unsigned char EMBEDDED_NET[394816] = {
  250,255,3,0,254,255,255,255,252,255,6,0,253,255,7,0,252,255,0,0,
  253,255,254,255,255,255,249,255,4,0,249,255,2,0,1,0,255,255,247,255,
  6,0,255,255,2,0,5,0,254,255,5,0,1,0,255,255,5,0,254,255,
@@ -2,169 +2,32 @@
 #include "chess/bitboard.hpp"
 #include "chess/attacks.hpp"
 #include "chess/nnue.hpp"
+#include "chess/psqt.hpp"
 
 #include <algorithm>
 
 namespace chess {
 namespace {
 
+using namespace psqt;
+
 // =============================================================================
 // Tapered evaluation: a midgame score and an endgame score are blended by the
 // game phase. Foundation is PeSTO (tuned material + piece-square tables, public
-// domain); on top we add mobility, the bishop pair, rooks on (semi-)open files,
-// and doubled/isolated pawn penalties - the positional terms a bare PSQT misses.
-//
-// PeSTO tables are written a8=0 (rank 8 first). Our squares are LERF (a1=0), so
-// a WHITE piece reads table[sq ^ 56] and a BLACK piece reads table[sq].
+// domain; chess/psqt.hpp); on top we add mobility, the bishop pair, rooks on
+// (semi-)open files, and doubled/isolated pawn penalties - the positional terms
+// a bare PSQT misses.
 // =============================================================================
 
-// Material, indexed by PieceType (PAWN..KING).
-constexpr int MG_VAL[PIECE_TYPE_NB] = {0, 82, 337, 365, 477, 1025, 0};
-constexpr int EG_VAL[PIECE_TYPE_NB] = {0, 94, 281, 297, 512, 936, 0};
-
-// Game-phase weights and mobility weights, by PieceType.
-constexpr int PHASE_W[PIECE_TYPE_NB] = {0, 0, 1, 1, 2, 4, 0};
-constexpr int PHASE_MAX = 24;
+// Mobility weights, by PieceType.
 constexpr int MOB_MG[PIECE_TYPE_NB]  = {0, 0, 4, 4, 2, 1, 0};
 constexpr int MOB_EG[PIECE_TYPE_NB]  = {0, 0, 4, 5, 4, 2, 0};
 
-// Piece-square tables [PieceType][square], a8=0 ordering. Row 0 (NO_PIECE_TYPE) unused.
-constexpr int MG_PSQT[PIECE_TYPE_NB][64] = {
-    {}, // NO_PIECE_TYPE
-    {   // PAWN
-          0,   0,   0,   0,   0,   0,   0,   0,
-         98, 134,  61,  95,  68, 126,  34, -11,
-         -6,   7,  26,  31,  65,  56,  25, -20,
-        -14,  13,   6,  21,  23,  12,  17, -23,
-        -27,  -2,  -5,  12,  17,   6,  10, -25,
-        -26,  -4,  -4, -10,   3,   3,  33, -12,
-        -35,  -1, -20, -23, -15,  24,  38, -22,
-          0,   0,   0,   0,   0,   0,   0,   0,
-    },
-    {   // KNIGHT
-       -167, -89, -34, -49,  61, -97, -15,-107,
-        -73, -41,  72,  36,  23,  62,   7, -17,
-        -47,  60,  37,  65,  84, 129,  73,  44,
-         -9,  17,  19,  53,  37,  69,  18,  22,
-        -13,   4,  16,  13,  28,  19,  21,  -8,
-        -23,  -9,  12,  10,  19,  17,  25, -16,
-        -29, -53, -12,  -3,  -1,  18, -14, -19,
-       -105, -21, -58, -33, -17, -28, -19, -23,
-    },
-    {   // BISHOP
-        -29,   4, -82, -37, -25, -42,   7,  -8,
-        -26,  16, -18, -13,  30,  59,  18, -47,
-        -16,  37,  43,  40,  35,  50,  37,  -2,
-         -4,   5,  19,  50,  37,  37,   7,  -2,
-         -6,  13,  13,  26,  34,  12,  10,   4,
-          0,  15,  15,  15,  14,  27,  18,  10,
-          4,  15,  16,   0,   7,  21,  33,   1,
-        -33,  -3, -14, -21, -13, -12, -39, -21,
-    },
-    {   // ROOK
-         32,  42,  32,  51,  63,   9,  31,  43,
-         27,  32,  58,  62,  80,  67,  26,  44,
-         -5,  19,  26,  36,  17,  45,  61,  16,
-        -24, -11,   7,  26,  24,  35,  -8, -20,
-        -36, -26, -12,  -1,   9,  -7,   6, -23,
-        -45, -25, -16, -17,   3,   0,  -5, -33,
-        -44, -16, -20,  -9,  -1,  11,  -6, -71,
-        -19, -13,   1,  17,  16,   7, -37, -26,
-    },
-    {   // QUEEN
-        -28,   0,  29,  12,  59,  44,  43,  45,
-        -24, -39,  -5,   1, -16,  57,  28,  54,
-        -13, -17,   7,   8,  29,  56,  47,  57,
-        -27, -27, -16, -16,  -1,  17,  -2,   1,
-         -9, -26,  -9, -10,  -2,  -4,   3,  -3,
-        -14,   2, -11,  -2,  -5,   2,  14,   5,
-        -35,  -8,  11,   2,   8,  15,  -3,   1,
-         -1, -18,  -9,  10, -15, -25, -31, -50,
-    },
-    {   // KING
-        -65,  23,  16, -15, -56, -34,   2,  13,
-         29,  -1, -20,  -7,  -8,  -4, -38, -29,
-         -9,  24,   2, -16, -20,   6,  22, -22,
-        -17, -20, -12, -27, -30, -25, -14, -36,
-        -49,  -1, -27, -39, -46, -44, -33, -51,
-        -14, -14, -22, -46, -44, -30, -15, -27,
-          1,   7,  -8, -64, -43, -16,   9,   8,
-        -15,  36,  12, -54,   8, -28,  24,  14,
-    },
-};
-
-constexpr int EG_PSQT[PIECE_TYPE_NB][64] = {
-    {}, // NO_PIECE_TYPE
-    {   // PAWN
-          0,   0,   0,   0,   0,   0,   0,   0,
-        178, 173, 158, 134, 147, 132, 165, 187,
-         94, 100,  85,  67,  56,  53,  82,  84,
-         32,  24,  13,   5,  -2,   4,  17,  17,
-         13,   9,  -3,  -7,  -7,  -8,   3,  -1,
-          4,   7,  -6,   1,   0,  -5,  -1,  -8,
-         13,   8,   8,  10,  13,   0,   2,  -7,
-          0,   0,   0,   0,   0,   0,   0,   0,
-    },
-    {   // KNIGHT
-        -58, -38, -13, -28, -31, -27, -63, -99,
-        -25,  -8, -25,  -2,  -9, -25, -24, -52,
-        -24, -20,  10,   9,  -1,  -9, -19, -41,
-        -17,   3,  22,  22,  22,  11,   8, -18,
-        -18,  -6,  16,  25,  16,  17,   4, -18,
-        -23,  -3,  -1,  15,  10,  -3, -20, -22,
-        -42, -20, -10,  -5,  -2, -20, -23, -44,
-        -29, -51, -23, -15, -22, -18, -50, -64,
-    },
-    {   // BISHOP
-        -14, -21, -11,  -8,  -7,  -9, -17, -24,
-         -8,  -4,   7, -12,  -3, -13,  -4, -14,
-          2,  -8,   0,  -1,  -2,   6,   0,   4,
-         -3,   9,  12,   9,  14,  10,   3,   2,
-         -6,   3,  13,  19,   7,  10,  -3,  -9,
-        -12,  -3,   8,  10,  13,   3,  -7, -15,
-        -14, -18,  -7,  -1,   4,  -9, -15, -27,
-        -23,  -9, -23,  -5,  -9, -16,  -5, -17,
-    },
-    {   // ROOK
-         13,  10,  18,  15,  12,  12,   8,   5,
-         11,  13,  13,  11,  -3,   3,   8,   3,
-          7,   7,   7,   5,   4,  -3,  -5,  -3,
-          4,   3,  13,   1,   2,   1,  -1,   2,
-          3,   5,   8,   4,  -5,  -6,  -8, -11,
-         -4,   0,  -5,  -1,  -7, -12,  -8, -16,
-         -6,  -6,   0,   2,  -9,  -9, -11,  -3,
-         -9,   2,   3,  -1,  -5, -13,   4, -20,
-    },
-    {   // QUEEN
-         -9,  22,  22,  27,  27,  19,  10,  20,
-        -17,  20,  32,  41,  58,  25,  30,   0,
-        -20,   6,   9,  49,  47,  35,  19,   9,
-          3,  22,  24,  45,  57,  40,  57,  36,
-        -18,  28,  19,  47,  31,  34,  39,  23,
-        -16, -27,  15,   6,   9,  17,  10,   5,
-        -22, -23, -30, -16, -16, -23, -36, -32,
-        -33, -28, -22, -43,  -5, -32, -20, -41,
-    },
-    {   // KING
-        -74, -35, -18, -18, -11,  15,   4, -17,
-        -12,  17,  14,  17,  17,  38,  23,  11,
-         10,  17,  23,  15,  20,  45,  44,  13,
-         -8,  22,  24,  27,  26,  33,  26,   3,
-        -18,  -4,  21,  24,  27,  23,   9, -11,
-        -19,  -3,  11,  21,  23,  16,   7,  -9,
-        -27, -11,   4,  13,  14,   4,  -5, -17,
-        -53, -34, -21, -11, -28, -14, -24, -43,
-    },
-};
+// King safety: weight of a piece attacking the enemy king zone, by PieceType.
+constexpr int KING_ATTACK_WEIGHT[PIECE_TYPE_NB] = {0, 0, 20, 20, 40, 80, 0};
 
 Bitboard file_bb(File f) { return FILE_A_BB << f; }
 
-// Squares a side's pawns attack (the two forward diagonals).
-Bitboard pawn_attacks_bb(Color c, Bitboard pawns) {
-    return (c == WHITE) ? (north_east(pawns) | north_west(pawns))
-                        : (south_east(pawns) | south_west(pawns));
-}
-
 Bitboard piece_attacks(PieceType pt, Square s, Bitboard occ) {
     switch (pt) {
         case KNIGHT: return knight_attacks(s);
@@ -175,36 +38,116 @@ Bitboard piece_attacks(PieceType pt, Square s, Bitboard occ) {
     }
 }
 
+// Attack maps for one evaluation, built once and read by every term: what each
+// side attacks with each piece type, everything it attacks, and what it attacks
+// at least twice. Attacks on the enemy king zone are tallied on the way.
+struct EvalInfo {
+    Bitboard attackedBy[COLOR_NB][PIECE_TYPE_NB] = {};   // [c][NO_PIECE_TYPE]: all of c's attacks
+    Bitboard attackedBy2[COLOR_NB]               = {};
+    Bitboard kingZone[COLOR_NB]                  = {};   // c's king square and its neighbours
+    int      kingAttackers[COLOR_NB]             = {};   // c's pieces attacking the enemy king zone
+    int      kingAttackWeight[COLOR_NB]          = {};   // ...weighted by KING_ATTACK_WEIGHT
+
+    void add(Color c, PieceType pt, Bitboard att) {
+        attackedBy2[c]               |= attackedBy[c][NO_PIECE_TYPE] & att;
+        attackedBy[c][NO_PIECE_TYPE] |= att;
+        attackedBy[c][pt]            |= att;
+    }
+};
+
+// Pawn and king attacks and the king zones: what the piece terms need first.
+void init_eval_info(const Position& pos, EvalInfo& ei) {
+    for (Color c = WHITE; c <= BLACK; c = Color(c + 1)) {
+        const Bitboard pawns = pos.pieces(c, PAWN);
+        const Bitboard west  = (c == WHITE) ? north_west(pawns) : south_west(pawns);
+        const Bitboard east  = (c == WHITE) ? north_east(pawns) : south_east(pawns);
+        ei.attackedBy[c][PAWN] = ei.attackedBy[c][NO_PIECE_TYPE] = west | east;
+        ei.attackedBy2[c]      = west & east;
+
+        const Square ksq = pos.king_square(c);
+        ei.kingZone[c] = king_attacks(ksq) | square_bb(ksq);
+        ei.add(c, KING, king_attacks(ksq));
+    }
+}
+
+// How exposed c's king is to the enemy's pieces, in danger units (0 if fewer
+// than two of them attack its zone - one, if they still have a queen). Counts
+// the attackers' weights, the zone squares we defend weakly, and the safe
+// checks each enemy piece type has available.
+int king_danger(const Position& pos, const EvalInfo& ei, Color c) {
+    const Color them = ~c;
+    if (ei.kingAttackers[them] < (pos.pieces(them, QUEEN) ? 1 : 2)) return 0;
+
+    const Square   ksq  = pos.king_square(c);
+    const Bitboard occ  = pos.pieces();
+    // Attacked squares we defend at most once, and only with the king or queen.
+    const Bitboard weak = ei.attackedBy[them][NO_PIECE_TYPE] & ~ei.attackedBy2[c]
+                        & (~ei.attackedBy[c][NO_PIECE_TYPE] | ei.attackedBy[c][KING]
+                           | ei.attackedBy[c][QUEEN]);
+    // Where a checking piece would not simply be taken.
+    const Bitboard safe = ~pos.pieces(them)
+                        & (~ei.attackedBy[c][NO_PIECE_TYPE] | (weak & ei.attackedBy2[them]));
+    const Bitboard rookChecks   = rook_attacks(ksq, occ) & safe;
+    const Bitboard bishopChecks = bishop_attacks(ksq, occ) & safe;
+
+    int danger = ei.kingAttackWeight[them] + 12 * popcount(weak & ei.kingZone[c]);
+    if ((rookChecks | bishopChecks) & ei.attackedBy[them][QUEEN]) danger += 60;
+    if (rookChecks   & ei.attackedBy[them][ROOK])                 danger += 80;
+    if (bishopChecks & ei.attackedBy[them][BISHOP])               danger += 40;
+    if (knight_attacks(ksq) & safe & ei.attackedBy[them][KNIGHT]) danger += 60;
+    return std::min(danger, 500);
+}
+
+// Threats by c: enemy pieces attacked by a pawn, rooks and queens attacked by
+// a minor, and pieces attacked but not defended at all. Adds to mg/eg (c's view).
+void threats(const Position& pos, const EvalInfo& ei, Color c, int& mg, int& eg) {
+    const Color    them    = ~c;
+    const Bitboard targets = pos.pieces(them) & ~pos.pieces(PAWN) & ~pos.pieces(KING);
+
+    const Bitboard byPawn  = targets & ei.attackedBy[c][PAWN];
+    const Bitboard byMinor = (pos.pieces(them, ROOK) | pos.pieces(them, QUEEN))
+                           & (ei.attackedBy[c][KNIGHT] | ei.attackedBy[c][BISHOP]);
+    const Bitboard hanging = targets & ~byPawn & ei.attackedBy[c][NO_PIECE_TYPE]
+                           & ~ei.attackedBy[them][NO_PIECE_TYPE];
+    mg += 60 * popcount(byPawn) + 35 * popcount(byMinor) + 40 * popcount(hanging);
+    eg += 40 * popcount(byPawn) + 40 * popcount(byMinor) + 20 * popcount(hanging);
+}
+
 } // namespace
 
 // Hand-crafted evaluation (the baseline). Used when no NNUE net is loaded.
+// Material, piece-square values and the phase come from Position's incremental
+// sums; mobility, king safety and threats read one set of attack maps
+// (EvalInfo) built here, next to the rook-file and pawn-structure terms.
 int evaluate_hce(const Position& pos) {
     const Bitboard occ = pos.pieces();
-    int mg = 0, eg = 0, phase = 0;   // mg/eg accumulate from White's perspective
+    // mg/eg accumulate from White's perspective
+    int mg = pos.psq_mg(WHITE) - pos.psq_mg(BLACK);
+    int eg = pos.psq_eg(WHITE) - pos.psq_eg(BLACK);
+
+    EvalInfo ei;
+    init_eval_info(pos, ei);
 
     for (Color c = WHITE; c <= BLACK; c = Color(c + 1)) {
         const int      sign     = (c == WHITE) ? 1 : -1;
-        const Bitboard own      = pos.pieces(c);
         const Bitboard myPawns  = pos.pieces(c, PAWN);
         const Bitboard oppPawns = pos.pieces(~c, PAWN);
         // Don't credit "mobility" to squares an enemy pawn covers: a knight that
         // can only step onto a pawn-guarded square isn't really mobile there.
-        const Bitboard safe     = ~own & ~pawn_attacks_bb(~c, oppPawns);
+        const Bitboard safe     = ~pos.pieces(c) & ~ei.attackedBy[~c][PAWN];
 
-        for (PieceType pt = PAWN; pt <= KING; pt = PieceType(pt + 1)) {
+        for (PieceType pt = KNIGHT; pt <= QUEEN; pt = PieceType(pt + 1)) {
             Bitboard b = pos.pieces(c, pt);
-            phase += popcount(b) * PHASE_W[pt];
             while (b) {
-                Square s   = pop_lsb(b);
-                int    idx = (c == WHITE) ? (s ^ 56) : s;   // PeSTO orientation
-                mg += sign * (MG_VAL[pt] + MG_PSQT[pt][idx]);
-                eg += sign * (EG_VAL[pt] + EG_PSQT[pt][idx]);
-
-                if (pt == KNIGHT || pt == BISHOP || pt == ROOK || pt == QUEEN) {
-                    int m = popcount(piece_attacks(pt, s, occ) & safe);
-                    mg += sign * m * MOB_MG[pt];
-                    eg += sign * m * MOB_EG[pt];
+                const Bitboard att = piece_attacks(pt, pop_lsb(b), occ);
+                ei.add(c, pt, att);
+                if (att & ei.kingZone[~c]) {
+                    ++ei.kingAttackers[c];
+                    ei.kingAttackWeight[c] += KING_ATTACK_WEIGHT[pt];
                 }
+                int m = popcount(att & safe);
+                mg += sign * m * MOB_MG[pt];
+                eg += sign * m * MOB_EG[pt];
             }
         }
 
@@ -234,7 +177,20 @@ int evaluate_hce(const Position& pos) {
         }
     }
 
-    phase = std::min(phase, PHASE_MAX);
+    // King safety and threats read the finished attack maps of both sides.
+    for (Color c = WHITE; c <= BLACK; c = Color(c + 1)) {
+        const int sign   = (c == WHITE) ? 1 : -1;
+        const int danger = king_danger(pos, ei, c);
+        mg -= sign * danger * danger / 512;
+        eg -= sign * danger / 8;
+
+        int tmg = 0, teg = 0;
+        threats(pos, ei, c, tmg, teg);
+        mg += sign * tmg;
+        eg += sign * teg;
+    }
+
+    const int phase = std::min(pos.phase(), PHASE_MAX);
     int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
     return (pos.side_to_move() == WHITE) ? score : -score;
 }
@@ -244,7 +200,8 @@ int evaluate(const Position& pos) {
     // from-scratch accumulator refresh per call (correct, not yet fast); Phase 2
     // makes the accumulator incremental on Position. Same swappable interface.
     if (nnue::is_loaded())
-        return nnue::forward(pos.accumulator(), pos.side_to_move());  // incremental, lazy-refreshed
+        return nnue::forward(pos.accumulator(), pos.side_to_move(),   // incremental, lazy-refreshed
+                             popcount(pos.pieces()));
     return evaluate_hce(pos);
 }
 
@@ -3,14 +3,22 @@
 // `bullet` trainer's `simple` example exactly, so we load bullet's raw .bin
 // output directly - no custom exporter, no format mismatch (the #1 NNUE bug).
 //
-//   (768 -> L1) x2  ->  1        [perspective accumulators concatenated: stm, ntm]
+//   (768 -> L1) x2  ->  1 x N    [perspective accumulators concatenated: stm, ntm]
 //   activation: SCReLU (squared clipped ReLU), QA=255 QB=64, eval scale 400
+//   output bucket: (popcount(pieces) - 2) / ceil(32 / N)   [bullet MaterialCount<N>]
 //
 // File layout (bullet `Network`, little-endian, all i16):
 //   feature_weights[768 * L1]   column-major: feature f's column = [f*L1 .. f*L1+L1)
 //   feature_bias[L1]
-//   output_weights[2 * L1]      first L1 = stm side, next L1 = ntm side
-//   output_bias                 (1)
+//   output_weights[N][2 * L1]   per bucket: first L1 = stm side, next L1 = ntm side
+//   output_bias[N]
+// N is not stored: it is whatever the file size holds (1..MAX_OUTPUT_BUCKETS),
+// so a single-bucket file is exactly the original format.
+//
+// The weights are used where they lie: an EvalFile is memory-mapped (several
+// engine processes share one page-cached copy) and the embedded net is read
+// straight out of the binary's read-only data. Only an embedded array that is
+// not 64-byte aligned, or a generated test net, gets a heap copy.
 //
 // This file owns ONLY shared, read-only weights + pure functions over an
 // Accumulator. The Accumulator is per-position state on Position, so nothing here
@@ -18,13 +26,14 @@
 // =============================================================================
 
 #include "chess/nnue.hpp"
+#include "chess/mapped_file.hpp"
 #include "chess/position.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
-#include <iterator>
 #include <random>
 #include <vector>
 
@@ -49,11 +58,22 @@ constexpr std::int32_t QA    = 255;   // feature-transformer quantization
 constexpr std::int32_t QB    = 64;    // output-weights quantization
 constexpr std::int32_t SCALE = 400;   // eval scale (centipawns)
 
+// One cache line of weights: the unit of the (64-byte aligned) owned storage.
+struct alignas(64) WeightBlock { std::int16_t w[32]; };
+
 struct Network {
-    std::vector<std::int16_t> ftW;   // [INPUT_DIM * L1] feature weights (col-major)
-    std::vector<std::int16_t> ftB;   // [L1] feature bias
-    std::vector<std::int16_t> outW;  // [2*L1] output weights (stm half, ntm half)
-    std::int16_t              outB = 0;
+    const std::int16_t* ftW  = nullptr;   // [INPUT_DIM * L1] feature weights (col-major)
+    const std::int16_t* ftB  = nullptr;   // [L1] feature bias
+    const std::int16_t* outW = nullptr;   // [buckets][2*L1] output weights (stm half, ntm half)
+    const std::int16_t* outB = nullptr;   // [buckets] output bias
+    int buckets   = 1;
+    int bucketDiv = 32;                   // pieces per bucket: ceil(32 / buckets)
+    std::array<std::uint16_t, L1> order{};   // neuron order the arrays are in (transform_net)
+
+    // Whatever the pointers above point into (at most one is in use; neither
+    // for an embedded net used in place). Moving a Network keeps the addresses.
+    MappedFile               file;
+    std::vector<WeightBlock> owned;
 };
 
 Network g_net;
@@ -65,48 +85,134 @@ inline std::int32_t screlu(std::int16_t x) {
     return y * y;
 }
 
-// Parse bullet's raw .bin layout (four i16 arrays, no header) from a byte buffer.
-// Both file and embedded loaders funnel through here. `size` must hold at least
-// the four arrays; trailing padding (bullet aligns to 64 bytes) is ignored.
+void set_buckets(Network& n, int buckets) {
+    n.buckets   = buckets;
+    n.bucketDiv = (32 + buckets - 1) / buckets;
+}
+
+// Point `n` at bullet's raw .bin layout (four i16 arrays, no header) in a byte
+// buffer that outlives it; nothing is copied. Both file and embedded loaders
+// funnel through here. `p` must be 64-byte aligned (every array then is too).
+// The output bucket count is however many (2*L1 weights + 1 bias) groups fit
+// after the feature transformer; trailing padding (bullet aligns to 64 bytes,
+// less than one group) is ignored.
 bool parse_net(const unsigned char* p, std::size_t size, Network& n) {
-    const std::size_t need = (std::size_t(INPUT_DIM) * L1 + L1 + 2 * L1 + 1) * sizeof(std::int16_t);
-    if (size < need) return false;
-    auto take = [&](std::vector<std::int16_t>& v, std::size_t count) {
-        v.resize(count);
-        std::memcpy(v.data(), p, count * sizeof(std::int16_t));
+    const std::size_t ftWords = std::size_t(INPUT_DIM) * L1 + L1;
+    const std::size_t words   = size / sizeof(std::int16_t);
+    if (words < ftWords) return false;
+    const std::size_t buckets = (words - ftWords) / (2 * L1 + 1);
+    if (buckets < 1 || buckets > std::size_t(MAX_OUTPUT_BUCKETS)) return false;
+    set_buckets(n, int(buckets));
+    auto take = [&](const std::int16_t*& v, std::size_t count) {
+        v = reinterpret_cast<const std::int16_t*>(p);
         p += count * sizeof(std::int16_t);
     };
     take(n.ftW,  std::size_t(INPUT_DIM) * L1);
     take(n.ftB,  L1);
-    take(n.outW, std::size_t(2) * L1);
-    std::memcpy(&n.outB, p, sizeof(std::int16_t));
+    take(n.outW, buckets * 2 * L1);
+    take(n.outB, buckets);
+    return true;
+}
+
+// ---- Load-time layout transform ---------------------------------------------
+// The kernels may want the L1 neurons in another order than the file's (a
+// packus-based int8 path, for one, interleaves 128-bit lanes). NEURON_ORDER[i]
+// is the file neuron kept at position i; the same permutation applies to every
+// feature column, the feature bias and both halves of every output bucket, so
+// the eval is the same whatever it is. The current kernels are lane-order
+// agnostic (element-wise adds, a full-width dot), so it is the identity and the
+// weights stay where they were loaded. g_order is the order the next load uses:
+// NEURON_ORDER unless a test has set another (set_neuron_order).
+constexpr std::array<std::uint16_t, L1> make_neuron_order() {
+    std::array<std::uint16_t, L1> order{};
+    for (int i = 0; i < L1; ++i) order[i] = std::uint16_t(i);
+    return order;
+}
+constexpr std::array<std::uint16_t, L1> NEURON_ORDER = make_neuron_order();
+
+std::array<std::uint16_t, L1> g_order = NEURON_ORDER;
+
+bool natural_order(const std::array<std::uint16_t, L1>& order) {
+    for (int i = 0; i < L1; ++i)
+        if (order[i] != i) return false;
     return true;
 }
 
+std::size_t net_words(int buckets) {
+    return std::size_t(INPUT_DIM) * L1 + L1 + std::size_t(buckets) * (2 * L1 + 1);
+}
+
+// Write `n`'s arrays to `dst` (net_words long) in file layout, each L1-wide row
+// gathered through n.order (file -> kernel order, at load) or, ToFile,
+// scattered back through it (the inverse, for export).
+template <bool ToFile>
+void copy_permuted(const Network& n, std::int16_t* dst) {
+    auto rows = [&](const std::int16_t* src, std::size_t count) {
+        for (std::size_t r = 0; r < count; ++r, src += L1, dst += L1)
+            for (int i = 0; i < L1; ++i) {
+                if (ToFile) dst[n.order[i]] = src[i];
+                else        dst[i] = src[n.order[i]];
+            }
+    };
+    rows(n.ftW, INPUT_DIM);
+    rows(n.ftB, 1);
+    rows(n.outW, std::size_t(2) * n.buckets);
+    std::copy(n.outB, n.outB + n.buckets, dst);
+}
+
+// Bring a parsed net into kernel order: nothing to do for the natural order,
+// otherwise one permuted, aligned copy that replaces whatever held the file.
+void transform_net(Network& n) {
+    n.order = g_order;
+    if (natural_order(n.order)) return;
+    const std::size_t bytes = net_words(n.buckets) * sizeof(std::int16_t);
+    std::vector<WeightBlock> buf(bytes / sizeof(WeightBlock) + 1);
+    copy_permuted<false>(n, buf.front().w);
+    parse_net(reinterpret_cast<const unsigned char*>(buf.data()), bytes, n);
+    n.owned = std::move(buf);   // moving keeps the addresses just bound
+    n.file.close();
+}
+
 } // namespace
 
 bool is_loaded() { return g_loaded; }
 
+int output_buckets() { return g_net.buckets; }
+
 void unload() { g_loaded = false; }
 
 bool load(const std::string& path) {
     g_loaded = false;
-    std::ifstream f(path, std::ios::binary);
-    if (!f) return false;
-    std::vector<unsigned char> buf((std::istreambuf_iterator<char>(f)),
-                                    std::istreambuf_iterator<char>());
-    Network n;
-    if (!parse_net(buf.data(), buf.size(), n)) return false;
+    Network n;   // the mapping is page-aligned
+    if (!n.file.open(path) || !parse_net(n.file.data(), n.file.size(), n)) return false;
+    transform_net(n);
     g_net = std::move(n);
     g_loaded = true;
     return true;
 }
 
+bool save(const std::string& path) {
+    if (!g_loaded) return false;
+    std::vector<std::int16_t> w(net_words(g_net.buckets));
+    copy_permuted<true>(g_net, w.data());
+    std::ofstream f(path, std::ios::binary);
+    f.write(reinterpret_cast<const char*>(w.data()), std::streamsize(w.size() * sizeof(std::int16_t)));
+    return bool(f);
+}
+
 bool load_embedded() {
     g_loaded = false;
     if (EMBEDDED_NET_SIZE == 0) return false;
     Network n;
-    if (!parse_net(EMBEDDED_NET, EMBEDDED_NET_SIZE, n)) return false;
+    const unsigned char* p = EMBEDDED_NET;
+    if (reinterpret_cast<std::uintptr_t>(p) % alignof(WeightBlock) != 0) {
+        // embed_net.py aligns the array; one aligned copy if a toolchain didn't.
+        n.owned.resize(EMBEDDED_NET_SIZE / sizeof(WeightBlock) + 1);
+        std::memcpy(n.owned.data(), p, EMBEDDED_NET_SIZE);
+        p = reinterpret_cast<const unsigned char*>(n.owned.data());
+    }
+    if (!parse_net(p, EMBEDDED_NET_SIZE, n)) return false;
+    transform_net(n);
     g_net = std::move(n);
     g_loaded = true;
     return true;
@@ -135,9 +241,10 @@ void refresh(Accumulator& acc, const Position& pos) {
     acc.valid = true;
 }
 
-// Forward pass from a valid accumulator. The side-to-move's perspective uses the
-// first L1 output weights, the opponent's the second half - so the result is
-// side-to-move-relative (same convention as the HCE evaluate()).
+// Forward pass from a valid accumulator. The piece count picks the output bucket;
+// within it the side-to-move's perspective uses the first L1 output weights, the
+// opponent's the second half - so the result is side-to-move-relative (same
+// convention as the HCE evaluate()).
 namespace {
 // Sum over L1 of screlu(acc[i]) * w[i]. The AVX2 path uses the Lizard SCReLU
 // trick: instead of (v*v)*w (which needs wide intermediates), reorder as
@@ -146,7 +253,8 @@ namespace {
 // (255*127 < 32767). Then _mm256_madd_epi16(v, v*w) computes the pairwise
 // products v*(v*w) = v^2*w = screlu*w AND sums adjacent pairs into int32 in one
 // instruction - no unpack/widen. Per-lane int32 sums stay small (16 terms each);
-// we widen to int64 only at the final horizontal reduction.
+// we widen to int64 only at the final horizontal reduction. Both operands are
+// 32-byte aligned (the accumulator by type, the weights by parse_net).
 inline std::int64_t dot_screlu(const std::int16_t* a, const std::int16_t* w) {
 #if NNUE_AVX2
     const __m256i zero = _mm256_setzero_si256();
@@ -155,7 +263,7 @@ inline std::int64_t dot_screlu(const std::int16_t* a, const std::int16_t* w) {
     for (int i = 0; i < L1; i += 16) {
         __m256i v  = _mm256_load_si256(reinterpret_cast<const __m256i*>(a + i));
         v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);        // clamp [0,QA]
-        __m256i wv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+        __m256i wv = _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i));
         __m256i vw = _mm256_mullo_epi16(v, wv);                     // v*w (fits int16)
         sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, vw));      // += sum_pairs(v * vw)
     }
@@ -174,13 +282,15 @@ inline std::int64_t dot_screlu(const std::int16_t* a, const std::int16_t* w) {
 }
 } // namespace
 
-int forward(const Accumulator& acc, Color stm) {
+int forward(const Accumulator& acc, Color stm, int pieceCount) {
     const Color opp = ~stm;
-    std::int64_t out = dot_screlu(acc.v[stm], &g_net.outW[0])
-                     + dot_screlu(acc.v[opp], &g_net.outW[L1]);
+    const int   b   = (pieceCount - 2) / g_net.bucketDiv;
+    const std::int16_t* w = &g_net.outW[std::size_t(b) * 2 * L1];
+    std::int64_t out = dot_screlu(acc.v[stm], w)
+                     + dot_screlu(acc.v[opp], w + L1);
 
     out /= QA;                       // SCReLU output is QA*QA*QB; reduce to QA*QB
-    out += g_net.outB;               // bias is at QA*QB
+    out += g_net.outB[b];            // bias is at QA*QB
     out *= SCALE;
     out /= (std::int64_t(QA) * QB);  // dequantize to centipawns
     return int(out);
@@ -190,7 +300,8 @@ int forward(const Accumulator& acc, Color stm) {
 // One perspective's accumulator += (Add ? +col : -col), over L1 int16. The AVX2
 // path does 16 int16 per instruction; the scalar path is the reference (and the
 // fallback when AVX2 is unavailable). Both must produce identical results - the
-// accumulator_matches_refresh gate verifies it.
+// accumulator_matches_refresh gate verifies it. Feature columns are 64-byte
+// aligned (parse_net), so every load is aligned.
 namespace {
 template <bool Add>
 inline void acc_update(std::int16_t* dst, const std::int16_t* col) {
@@ -198,7 +309,7 @@ inline void acc_update(std::int16_t* dst, const std::int16_t* col) {
     static_assert(L1 % 16 == 0, "L1 must be a multiple of 16 for the AVX2 path");
     for (int i = 0; i < L1; i += 16) {
         __m256i d = _mm256_load_si256(reinterpret_cast<const __m256i*>(dst + i));
-        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(col + i));
         d = Add ? _mm256_add_epi16(d, w) : _mm256_sub_epi16(d, w);
         _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), d);
     }
@@ -230,16 +341,25 @@ bool accumulator_matches_refresh(const Accumulator& acc, const Position& pos) {
 
 // Test/bootstrap helper: a small deterministic in-memory net (so the
 // incremental==refresh gate runs without a trained file). Not for play.
-void make_random_net(unsigned seed) {
+void set_neuron_order(const std::uint16_t* order) {
+    if (order) std::copy(order, order + L1, g_order.begin());
+    else       g_order = NEURON_ORDER;
+}
+
+void make_random_net(unsigned seed, int buckets) {
     std::mt19937 rng(seed);
     auto i16 = [&](int lo, int hi) {
         return std::int16_t(std::uniform_int_distribution<int>(lo, hi)(rng));
     };
+    // Generated in the file layout, then bound like a loaded net.
+    buckets = std::clamp(buckets, 1, MAX_OUTPUT_BUCKETS);
+    const std::size_t words = net_words(buckets);
     Network n;
-    n.ftW.resize(std::size_t(INPUT_DIM) * L1); for (auto& w : n.ftW)  w = i16(-32, 32);
-    n.ftB.resize(L1);                          for (auto& w : n.ftB)  w = i16(-32, 32);
-    n.outW.resize(std::size_t(2) * L1);        for (auto& w : n.outW) w = i16(-32, 32);
-    n.outB = i16(-32, 32);
+    n.owned.resize((words * sizeof(std::int16_t) + sizeof(WeightBlock) - 1) / sizeof(WeightBlock));
+    std::int16_t* w = n.owned.front().w;
+    for (std::size_t i = 0; i < words; ++i) w[i] = i16(-32, 32);
+    parse_net(reinterpret_cast<const unsigned char*>(w), words * sizeof(std::int16_t), n);
+    transform_net(n);
     g_net = std::move(n);
     g_loaded = true;
 }
@@ -19,136 +19,215 @@ void add_promotions(MoveList& list, Square from, Square to) {
     list.add(Move::make(from, to, PROMOTION, KNIGHT));
 }
 
-void generate_castling(const Position& pos, MoveList& list, Color us) {
-    const Color them = ~us;
-    if (us == WHITE) {
-        if ((pos.castling_rights() & WHITE_OO)
-            && pos.empty(SQ_F1) && pos.empty(SQ_G1)
-            && !pos.is_attacked(SQ_E1, them) && !pos.is_attacked(SQ_F1, them)
-            && !pos.is_attacked(SQ_G1, them))
-            list.add(Move::make(SQ_E1, SQ_G1, CASTLING));
-        if ((pos.castling_rights() & WHITE_OOO)
-            && pos.empty(SQ_B1) && pos.empty(SQ_C1) && pos.empty(SQ_D1)
-            && !pos.is_attacked(SQ_E1, them) && !pos.is_attacked(SQ_D1, them)
-            && !pos.is_attacked(SQ_C1, them))
-            list.add(Move::make(SQ_E1, SQ_C1, CASTLING));
-    } else {
-        if ((pos.castling_rights() & BLACK_OO)
-            && pos.empty(SQ_F8) && pos.empty(SQ_G8)
-            && !pos.is_attacked(SQ_E8, them) && !pos.is_attacked(SQ_F8, them)
-            && !pos.is_attacked(SQ_G8, them))
-            list.add(Move::make(SQ_E8, SQ_G8, CASTLING));
-        if ((pos.castling_rights() & BLACK_OOO)
-            && pos.empty(SQ_B8) && pos.empty(SQ_C8) && pos.empty(SQ_D8)
-            && !pos.is_attacked(SQ_E8, them) && !pos.is_attacked(SQ_D8, them)
-            && !pos.is_attacked(SQ_C8, them))
-            list.add(Move::make(SQ_E8, SQ_C8, CASTLING));
+// Color-dependent constants, resolved at compile time in each instantiation.
+template <Color Us> constexpr int      PAWN_PUSH  = (Us == WHITE) ? 8 : -8;
+template <Color Us> constexpr Bitboard START_RANK = (Us == WHITE) ? RANK_1_BB << 8 : RANK_8_BB >> 8;
+template <Color Us> constexpr Bitboard PROMO_RANK = (Us == WHITE) ? RANK_8_BB : RANK_1_BB;
+
+// Whole-set pawn steps for side Us: one square forward, and the two capture
+// directions (west = towards the a-file).
+template <Color Us> constexpr Bitboard pawn_push(Bitboard b) { return Us == WHITE ? north(b)      : south(b); }
+template <Color Us> constexpr Bitboard pawn_west(Bitboard b) { return Us == WHITE ? north_west(b) : south_west(b); }
+template <Color Us> constexpr Bitboard pawn_east(Bitboard b) { return Us == WHITE ? north_east(b) : south_east(b); }
+
+// Append a pawn move to each square in `to`, from the square `Offset` behind it.
+template <int Offset>
+void add_pawn_moves(MoveList& list, Bitboard to) {
+    while (to) { Square t = pop_lsb(to); list.add(Move::make(Square(t - Offset), t)); }
+}
+
+template <int Offset>
+void add_pawn_promotions(MoveList& list, Bitboard to) {
+    while (to) { Square t = pop_lsb(to); add_promotions(list, Square(t - Offset), t); }
+}
+
+template <Color Us>
+void generate_castling(const Position& pos, MoveList& list) {
+    constexpr Color  Them = ~Us;
+    constexpr Square K    = (Us == WHITE) ? SQ_E1 : SQ_E8;
+    constexpr int    OO   = (Us == WHITE) ? WHITE_OO  : BLACK_OO;
+    constexpr int    OOO  = (Us == WHITE) ? WHITE_OOO : BLACK_OOO;
+    constexpr Square F = Square(K + 1), G = Square(K + 2);
+    constexpr Square D = Square(K - 1), C = Square(K - 2), B = Square(K - 3);
+
+    if ((pos.castling_rights() & OO)
+        && pos.empty(F) && pos.empty(G)
+        && !pos.is_attacked(K, Them) && !pos.is_attacked(F, Them)
+        && !pos.is_attacked(G, Them))
+        list.add(Move::make(K, G, CASTLING));
+    if ((pos.castling_rights() & OOO)
+        && pos.empty(B) && pos.empty(C) && pos.empty(D)
+        && !pos.is_attacked(K, Them) && !pos.is_attacked(D, Them)
+        && !pos.is_attacked(C, Them))
+        list.add(Move::make(K, C, CASTLING));
+}
+
+// Pieces that are the ONLY piece (of either color) between `ksq` and a slider of
+// `sliderSide` aligned with it: pinned pieces when the slider is the enemy's,
+// discovered-check candidates when it is ours and `ksq` is the enemy king.
+Bitboard single_blockers(const Position& pos, Square ksq, Color sliderSide) {
+    const Bitboard occ = pos.pieces();
+    Bitboard blockers = 0;
+    Bitboard sliders  = ((pos.pieces(sliderSide, BISHOP) | pos.pieces(sliderSide, QUEEN)) & bishop_attacks(ksq, 0))
+                      | ((pos.pieces(sliderSide, ROOK)   | pos.pieces(sliderSide, QUEEN)) & rook_attacks(ksq, 0));
+    while (sliders) {
+        Bitboard b = between_bb(ksq, pop_lsb(sliders)) & occ;
+        if (popcount(b) == 1) blockers |= b;
     }
+    return blockers;
 }
 
-// Pseudo-legal moves: everything the pieces can do, NOT yet filtered for leaving
-// the own king in check. generate_legal does that filtering.
+// Pseudo-legal moves of one GenType for side `Us` (the side to move): everything
+// the pieces can do in that category, NOT yet filtered for leaving the own king in
+// check. generate_legal does that filtering.
 //
-// When `capturesOnly` is set, only "noisy" moves are emitted: captures, en
-// passant, and ALL promotions (including quiet push-promotions, which the
-// quiescence search also examines). Quiet non-promotion moves, double pushes and
-// castling are skipped. The emission ORDER of the noisy moves is identical to the
-// full generator (same piece/square order), so a stable move ordering produces
-// the exact same processed sequence in quiescence - the search stays bit-for-bit
-// identical, it just stops generating moves it would have discarded.
-void generate_pseudo(const Position& pos, MoveList& list, bool capturesOnly) {
-    const Color    us    = pos.side_to_move();
-    const Color    them  = ~us;
-    const Bitboard own   = pos.pieces(us);
-    const Bitboard enemy = pos.pieces(them);
+// Emission order is fixed for every type: knights, bishops+queens (diagonal),
+// rooks+queens (straight), king, pawns set-wise (promotions, captures west,
+// captures east, en passant, single pushes, double pushes - see below),
+// castling. Each type emits a subset of ALL in the same relative order, so a
+// stable move ordering processes, e.g., the CAPTURES in quiescence exactly as it
+// would have from the full list.
+//
+// `checkers` (the enemy pieces giving check) is only read by EVASIONS.
+template <Color Us, GenType Type>
+void generate_all(const Position& pos, MoveList& list, Bitboard checkers) {
+    constexpr Color Them = ~Us;
+    constexpr int   Up   = PAWN_PUSH<Us>;
+    const Bitboard own   = pos.pieces(Us);
+    const Bitboard enemy = pos.pieces(Them);
     const Bitboard occ   = pos.pieces();
+    const Square   ksq   = pos.king_square(Us);
+
+    // Destinations for the non-king pieces (`target`) and for the king.
+    Bitboard target = 0, kingTarget = 0;
+    if constexpr (Type == CAPTURES)                       target = kingTarget = enemy;
+    if constexpr (Type == QUIETS || Type == QUIET_CHECKS) target = kingTarget = ~occ;
+    if constexpr (Type == ALL)                            target = kingTarget = ~own;
+    if constexpr (Type == EVASIONS) {
+        // Single check: capture the checker or interpose on its ray. Double
+        // check: only the king may move. No castling out of check.
+        kingTarget = ~own;
+        target     = !checkers               ? ~own
+                   : popcount(checkers) == 1 ? ~own & (checkers | between_bb(ksq, lsb(checkers)))
+                                             : 0;
+    }
 
-    // Non-pawn pieces target enemy squares only in captures-only mode, otherwise
-    // every non-own square.
-    const Bitboard targets = capturesOnly ? enemy : ~own;
+    // QUIET_CHECKS: a quiet move checks directly if it lands on a square from
+    // which the moved piece attacks their king, or by discovery if the piece was
+    // the only blocker between their king and one of our sliders and leaves that
+    // line. checks_from(s, pt) is that destination set for a `pt` on `s`.
+    Square   theirKsq = SQ_NONE;
+    Bitboard checkSq[PIECE_TYPE_NB] = {};
+    Bitboard discoverers = 0;
+    if constexpr (Type == QUIET_CHECKS) {
+        theirKsq         = pos.king_square(Them);
+        checkSq[PAWN]    = pawn_attacks(Them, theirKsq);
+        checkSq[KNIGHT]  = knight_attacks(theirKsq);
+        checkSq[BISHOP]  = bishop_attacks(theirKsq, occ);
+        checkSq[ROOK]    = rook_attacks(theirKsq, occ);
+        checkSq[QUEEN]   = checkSq[BISHOP] | checkSq[ROOK];
+        discoverers      = single_blockers(pos, theirKsq, Us) & own;
+    }
+    auto checks_from = [&](Square s, PieceType pt) {
+        Bitboard b = checkSq[pt];
+        if (discoverers & square_bb(s)) b |= ~line_bb(theirKsq, s);
+        return b;
+    };
+
+    auto add_piece_moves = [&](Square s, Bitboard attacks, PieceType pt) {
+        Bitboard t = attacks & target;
+        if constexpr (Type == QUIET_CHECKS) t &= checks_from(s, pt);
+        add_targets(list, s, t);
+    };
 
     // Knights
-    Bitboard bb = pos.pieces(us, KNIGHT);
-    while (bb) { Square s = pop_lsb(bb); add_targets(list, s, knight_attacks(s) & targets); }
+    Bitboard bb = pos.pieces(Us, KNIGHT);
+    while (bb) { Square s = pop_lsb(bb); add_piece_moves(s, knight_attacks(s), KNIGHT); }
 
     // Bishops + queens (diagonal rays)
-    bb = pos.pieces(us, BISHOP) | pos.pieces(us, QUEEN);
-    while (bb) { Square s = pop_lsb(bb); add_targets(list, s, bishop_attacks(s, occ) & targets); }
+    bb = pos.pieces(Us, BISHOP) | pos.pieces(Us, QUEEN);
+    while (bb) { Square s = pop_lsb(bb); add_piece_moves(s, bishop_attacks(s, occ), type_of(pos.piece_on(s))); }
 
     // Rooks + queens (straight rays)
-    bb = pos.pieces(us, ROOK) | pos.pieces(us, QUEEN);
-    while (bb) { Square s = pop_lsb(bb); add_targets(list, s, rook_attacks(s, occ) & targets); }
-
-    // King (castling handled separately)
-    Square ks = pos.king_square(us);
-    add_targets(list, ks, king_attacks(ks) & targets);
-
-    // Pawns
-    const int  push      = (us == WHITE) ? 8 : -8;
-    const Rank startRank = (us == WHITE) ? RANK_2 : RANK_7;
-    const Rank promoRank = (us == WHITE) ? RANK_8 : RANK_1;
-
-    bb = pos.pieces(us, PAWN);
-    while (bb) {
-        Square s = pop_lsb(bb);
-
-        // Single (and double) push onto empty squares. A push to the last rank is
-        // a promotion (noisy) and is always emitted; ordinary quiet pushes are
-        // skipped in captures-only mode.
-        Square one = Square(s + push);
-        if (pos.empty(one)) {
-            if (rank_of(one) == promoRank) {
-                add_promotions(list, s, one);
-            } else if (!capturesOnly) {
-                list.add(Move::make(s, one));
-                Square two = Square(s + 2 * push);
-                if (rank_of(s) == startRank && pos.empty(two))
-                    list.add(Move::make(s, two));
-            }
-        }
+    bb = pos.pieces(Us, ROOK) | pos.pieces(Us, QUEEN);
+    while (bb) { Square s = pop_lsb(bb); add_piece_moves(s, rook_attacks(s, occ), type_of(pos.piece_on(s))); }
+
+    // King (castling handled separately). It never checks directly.
+    {
+        Bitboard t = king_attacks(ksq) & kingTarget;
+        if constexpr (Type == QUIET_CHECKS) t &= checks_from(ksq, KING);
+        add_targets(list, ksq, t);
+    }
 
-        // Diagonal captures (pawn_attacks already handles the edge files).
-        Bitboard caps = pawn_attacks(us, s) & enemy;
-        while (caps) {
-            Square t = pop_lsb(caps);
-            if (rank_of(t) == promoRank) add_promotions(list, s, t);
-            else                          list.add(Move::make(s, t));
+    // Pawns, all at once: shift the whole pawn set to get every destination of
+    // one kind of move, then recover each source square by the fixed offset.
+    // Push-promotions are noisy: CAPTURES (and ALL / EVASIONS) emit them, QUIETS
+    // and QUIET_CHECKS do not. Captures and en passant likewise.
+    //
+    // Order: promotions (push, capture west, capture east; Q, R, B, N each),
+    // captures west, captures east, en passant, single pushes, double pushes -
+    // each block by ascending destination square.
+    constexpr bool Noisy = (Type == CAPTURES || Type == ALL || Type == EVASIONS);
+    constexpr bool Quiet = (Type == QUIETS || Type == QUIET_CHECKS || Type == ALL || Type == EVASIONS);
+    constexpr int  West  = Up - 1, East = Up + 1;   // capture offsets (to - from)
+    const Bitboard noisyTarget = (Type == EVASIONS) ? target : ~Bitboard(0);
+    const Bitboard empty       = ~occ;
+    const Bitboard pawns       = pos.pieces(Us, PAWN);
+    const Bitboard onSeventh   = pawns & pawn_push<Them>(PROMO_RANK<Us>);
+    const Bitboard others      = pawns & ~onSeventh;
+
+    if constexpr (Noisy) {
+        if (onSeventh) {
+            add_pawn_promotions<Up>  (list, pawn_push<Us>(onSeventh) & empty & noisyTarget);
+            add_pawn_promotions<West>(list, pawn_west<Us>(onSeventh) & enemy & noisyTarget);
+            add_pawn_promotions<East>(list, pawn_east<Us>(onSeventh) & enemy & noisyTarget);
+        }
+        add_pawn_moves<West>(list, pawn_west<Us>(others) & enemy & noisyTarget);
+        add_pawn_moves<East>(list, pawn_east<Us>(others) & enemy & noisyTarget);
+
+        // En passant. As an evasion it must capture the checking pawn or land on
+        // the checking ray.
+        const Square ep = pos.ep_square();
+        if (ep != SQ_NONE && ((square_bb(ep) | square_bb(Square(ep - Up))) & noisyTarget)) {
+            Bitboard from = others & pawn_attacks(Them, ep);
+            while (from) list.add(Move::make(pop_lsb(from), ep, EN_PASSANT));
         }
+    }
 
-        // En passant.
-        if (pos.ep_square() != SQ_NONE
-            && (pawn_attacks(us, s) & square_bb(pos.ep_square())))
-            list.add(Move::make(s, pos.ep_square(), EN_PASSANT));
+    if constexpr (Quiet) {
+        Bitboard one = pawn_push<Us>(others) & empty;
+        Bitboard two = pawn_push<Us>(one & pawn_push<Us>(START_RANK<Us>)) & empty;
+        one &= target;
+        two &= target;
+        if constexpr (Type == QUIET_CHECKS) {
+            // A push checks directly from a pawn check square, or discovers one
+            // when the pawn blocked a line other than its own file.
+            const Bitboard discovering = others & discoverers & ~(FILE_A_BB << file_of(theirKsq));
+            one &= checkSq[PAWN] | pawn_push<Us>(discovering);
+            two &= checkSq[PAWN] | pawn_push<Us>(pawn_push<Us>(discovering));
+        }
+        add_pawn_moves<Up>(list, one);
+        add_pawn_moves<2 * Up>(list, two);
     }
 
-    if (!capturesOnly)
-        generate_castling(pos, list, us);
+    if constexpr (Type == QUIETS || Type == ALL)
+        generate_castling<Us>(pos, list);
 }
 
 // Filter a freshly generated pseudo-move list down to legal moves. Shared by the
 // full and captures-only entry points so the (subtle) legality logic lives once.
-void filter_legal(Position& pos, const MoveList& pseudo, MoveList& list) {
-
-    const Color    us   = pos.side_to_move();
-    const Color    them = ~us;
+template <Color Us>
+void filter_legal(Position& pos, const MoveList& pseudo, MoveList& list, Bitboard checkers) {
+    constexpr Color us   = Us;
+    constexpr Color them = ~Us;
     const Square   ksq  = pos.king_square(us);
     const Bitboard occ  = pos.pieces();
 
     // Enemy pieces giving check, and how many.
-    const Bitboard checkers    = pos.attackers_to(ksq, occ) & pos.pieces(them);
     const int      numCheckers = popcount(checkers);
 
-    // Pinned own pieces: for each enemy slider aligned with our king, if exactly one
-    // piece sits between them and it's ours, that piece is pinned to the king ray.
-    Bitboard pinned  = 0;
-    Bitboard pinners = ((pos.pieces(them, BISHOP) | pos.pieces(them, QUEEN)) & bishop_attacks(ksq, 0))
-                     | ((pos.pieces(them, ROOK)   | pos.pieces(them, QUEEN)) & rook_attacks(ksq, 0));
-    while (pinners) {
-        Square sq = pop_lsb(pinners);
-        Bitboard b = between_bb(ksq, sq) & occ;
-        if (popcount(b) == 1 && (b & pos.pieces(us)))
-            pinned |= b;
-    }
+    // Pinned own pieces: the only piece between our king and an enemy slider.
+    const Bitboard pinned = single_blockers(pos, ksq, them) & pos.pieces(us);
 
     // In single check, a non-king move is legal only if it lands on the checker or
     // interposes between it and the king. In double check, only the king can move.
@@ -197,22 +276,74 @@ void filter_legal(Position& pos, const MoveList& pseudo, MoveList& list) {
     }
 }
 
+template <Color Us>
+Bitboard checkers_of(const Position& pos) {
+    return pos.attackers_to(pos.king_square(Us), pos.pieces()) & pos.pieces(~Us);
+}
+
+// Legal moves of one type: the pseudo-legal list run through the filter. In
+// check, ALL is produced by the evasion generator - only king moves, captures
+// of the checker and blocks are generated at all, rather than every move
+// followed by the filter rejecting most of them.
+template <Color Us, GenType Type>
+void legal_moves(Position& pos, MoveList& list) {
+    const Bitboard checkers = checkers_of<Us>(pos);
+    MoveList pseudo;
+    if (Type == ALL && checkers) generate_all<Us, EVASIONS>(pos, pseudo, checkers);
+    else                         generate_all<Us, Type>(pos, pseudo, checkers);
+    filter_legal<Us>(pos, pseudo, list, checkers);
+}
+
 } // namespace
 
+template <Color Us, GenType Type>
+void generate(const Position& pos, MoveList& list) {
+    generate_all<Us, Type>(pos, list, Type == EVASIONS ? checkers_of<Us>(pos) : 0);
+}
+
+template <GenType Type>
+void generate(const Position& pos, MoveList& list) {
+    if (pos.side_to_move() == WHITE) generate<WHITE, Type>(pos, list);
+    else                             generate<BLACK, Type>(pos, list);
+}
+
+template <GenType Type>
 void generate_legal(Position& pos, MoveList& list) {
-    MoveList pseudo;
-    generate_pseudo(pos, pseudo, /*capturesOnly=*/false);
-    filter_legal(pos, pseudo, list);
+    if (pos.side_to_move() == WHITE) legal_moves<WHITE, Type>(pos, list);
+    else                             legal_moves<BLACK, Type>(pos, list);
+}
+
+void generate_legal(Position& pos, MoveList& list) {
+    generate_legal<ALL>(pos, list);
 }
 
 // Legal captures, en passant and promotions only - the quiescence search's move
 // set. Same legality filter as generate_legal; just a narrower pseudo list.
 void generate_legal_captures(Position& pos, MoveList& list) {
-    MoveList pseudo;
-    generate_pseudo(pos, pseudo, /*capturesOnly=*/true);
-    filter_legal(pos, pseudo, list);
+    generate_legal<CAPTURES>(pos, list);
 }
 
+template void generate<WHITE, CAPTURES>(const Position&, MoveList&);
+template void generate<WHITE, QUIETS>(const Position&, MoveList&);
+template void generate<WHITE, QUIET_CHECKS>(const Position&, MoveList&);
+template void generate<WHITE, EVASIONS>(const Position&, MoveList&);
+template void generate<WHITE, ALL>(const Position&, MoveList&);
+template void generate<BLACK, CAPTURES>(const Position&, MoveList&);
+template void generate<BLACK, QUIETS>(const Position&, MoveList&);
+template void generate<BLACK, QUIET_CHECKS>(const Position&, MoveList&);
+template void generate<BLACK, EVASIONS>(const Position&, MoveList&);
+template void generate<BLACK, ALL>(const Position&, MoveList&);
+template void generate<CAPTURES>(const Position&, MoveList&);
+template void generate<QUIETS>(const Position&, MoveList&);
+template void generate<QUIET_CHECKS>(const Position&, MoveList&);
+template void generate<EVASIONS>(const Position&, MoveList&);
+template void generate<ALL>(const Position&, MoveList&);
+template void generate_legal<CAPTURES>(Position&, MoveList&);
+template void generate_legal<QUIETS>(Position&, MoveList&);
+template void generate_legal<QUIET_CHECKS>(Position&, MoveList&);
+template void generate_legal<EVASIONS>(Position&, MoveList&);
+template void generate_legal<ALL>(Position&, MoveList&);
+
 std::uint64_t perft(Position& pos, int depth) {
     if (depth == 0) return 1;
 
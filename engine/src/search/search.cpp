@@ -1,14 +1,30 @@
 #include "chess/search.hpp"
+#include "chess/attacks.hpp"
 #include "chess/movegen.hpp"
 #include "chess/movelist.hpp"
 #include "chess/eval.hpp"
+#include "chess/tt.hpp"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -17,12 +33,16 @@
 //
 //   TranspositionTable - the ONE component shared between threads. Lockless:
 //                        entries are validated by key, torn writes are tolerated.
+//                        (chess/tt.hpp; each SearchEngine owns one.)
 //   SharedState        - everything shared, injected by reference into each
 //                        Worker (the TT, the limits, the stop flag, the game
 //                        history). Constructor injection = dependency injection.
 //   Worker             - all PER-THREAD mutable state (its own Position copy,
 //                        history/killers/counters, repetition list, node count)
 //                        plus the search itself as methods. N threads = N Workers.
+//   ThreadPool         - the SearchEngine's long-lived threads, one Worker each.
+//                        Idle threads sleep on a condition variable; a search
+//                        wakes them instead of spawning and joining threads.
 //
 // Because every search heuristic lives on Worker (per-thread) and the only shared
 // object is the TT (accessed through a narrow lockless interface), adding a new
@@ -34,13 +54,14 @@
 namespace chess {
 namespace {
 
-// The external abort flag (UCI `stop` / start-over). Injected into SharedState.
-std::atomic<bool> g_stop{false};
-
 constexpr int INF         = 32000;
 constexpr int MATE        = 31000;
 constexpr int MATE_IN_MAX = MATE - 256;   // scores beyond this are forced mates
 constexpr int MAX_PLY     = 128;
+constexpr int EVAL_NONE   = INF;          // TT eval slot: no static eval stored
+
+// Root `currmove` reports start once an iteration has run this long.
+constexpr std::int64_t CURRMOVE_AFTER_MS = 3000;
 
 // For MVV-LVA ordering and material-aware decisions, indexed by PieceType.
 constexpr int PIECE_VAL[PIECE_TYPE_NB] = {0, 100, 320, 330, 500, 900, 20000};
@@ -59,57 +80,6 @@ struct LmrTable {
 };
 const LmrTable LMR;
 
-// ---- Transposition table ----------------------------------------------------
-enum Bound : std::uint8_t { BOUND_NONE, BOUND_EXACT, BOUND_LOWER, BOUND_UPPER };
-
-struct TTEntry {
-    std::uint64_t key   = 0;
-    Move          move  = MOVE_NONE;
-    std::int16_t  score = 0;
-    std::int8_t   depth = 0;
-    std::uint8_t  bound = BOUND_NONE;
-};
-
-// The shared, lockless transposition table. One bucket per key (always-replace).
-// Reads are validated by the full key, so a torn concurrent write just looks
-// like a miss or is caught by the key check - acceptable for Lazy SMP.
-class TranspositionTable {
-public:
-    TranspositionTable() { resize(16); }   // 16 MB default (UCI Hash option)
-
-    // (Re)allocate to the largest power-of-two entry count fitting in `mb`
-    // megabytes, and clear. A bigger table = fewer collisions, which matters more
-    // the deeper / more-threaded the search (many threads hammering one TT).
-    void resize(std::size_t mb) {
-        std::size_t n = (mb * 1024 * 1024) / sizeof(TTEntry);
-        std::size_t p = 1;
-        while ((p << 1) <= n) p <<= 1;     // round down to a power of two
-        table_.assign(p, TTEntry{});
-        mask_ = table_.size() - 1;
-    }
-
-    void clear() { std::fill(table_.begin(), table_.end(), TTEntry{}); }
-
-    TTEntry* probe(std::uint64_t key, bool& hit) {
-        TTEntry* e = &table_[key & mask_];
-        hit = (e->key == key);
-        return e;
-    }
-
-    // Pull the bucket into cache ahead of the probe (hardware prefetch).
-    void prefetch(std::uint64_t key) const {
-#if defined(__GNUC__) || defined(__clang__)
-        __builtin_prefetch(&table_[key & mask_]);
-#endif
-    }
-
-private:
-    std::vector<TTEntry> table_;
-    std::size_t          mask_ = 0;
-};
-
-TranspositionTable g_tt;   // the single shared table (kept across moves)
-
 // Mate scores are stored relative to the node (not the root), so the same entry
 // is valid at any ply: shift by `ply` on store and unshift on probe.
 int to_tt(int score, int ply) {
@@ -128,65 +98,137 @@ bool has_non_pawn_material(const Position& p, Color c) {
           | p.pieces(c, ROOK)   | p.pieces(c, QUEEN)) != 0;
 }
 
-// Static Exchange Evaluation: the material swing if the capture `m` is followed
-// by the best sequence of recaptures on its target square (swap algorithm). A
-// negative result means the capture loses material. attackers_to is recomputed
-// with an updated occupancy each step, which naturally reveals X-ray attackers.
-// Pure function of the position - no per-thread state, safe to share.
-int see(const Position& pos, Move m) {
+// The pieces of `c` pinned to their king by an enemy slider, and those sliders.
+void king_pins(const Position& pos, Color c, Bitboard& pinned, Bitboard& pinners) {
+    const Square ksq  = pos.king_square(c);
+    const Color  them = ~c;
+    Bitboard snipers = ((pos.pieces(them, BISHOP) | pos.pieces(them, QUEEN)) & bishop_attacks(ksq, 0))
+                     | ((pos.pieces(them, ROOK)   | pos.pieces(them, QUEEN)) & rook_attacks(ksq, 0));
+    pinned = pinners = 0;
+    while (snipers) {
+        const Square   s = pop_lsb(snipers);
+        const Bitboard b = between_bb(ksq, s) & pos.pieces();
+        if (popcount(b) == 1 && (b & pos.pieces(c))) { pinned |= b; pinners |= square_bb(s); }
+    }
+}
+
+} // namespace
+
+// Static Exchange Evaluation as a threshold test: does the capture `m`, followed
+// by the best sequence of recaptures on its target square (swap algorithm), win
+// at least `threshold` material? The attackers of the square are computed once;
+// as each capturer leaves, only the sliders behind it are added (the x-rays), and
+// the loop stops as soon as the outcome relative to `threshold` is decided.
+// A piece pinned to its king does not recapture while its pinner is on the
+// board; a promotion counts as the pawn it was. A non-capture is worth 0. Pure
+// function of the position - safe to share.
+bool see_ge(const Position& pos, Move m, int threshold) {
     const Square from = m.from_sq();
     const Square to   = m.to_sq();
     const bool   ep   = (m.type_of() == EN_PASSANT);
 
-    PieceType victim = ep ? PAWN : type_of(pos.piece_on(to));
-    if (victim == NO_PIECE_TYPE) return 0;   // not a capture
+    const PieceType victim = ep ? PAWN : type_of(pos.piece_on(to));
+    if (victim == NO_PIECE_TYPE) return 0 >= threshold;   // not a capture
 
-    int gain[32];
-    int d = 0;
-    gain[0] = PIECE_VAL[victim];
+    // `swap` is what the side that just captured is ahead by, relative to the
+    // threshold, if the exchange stopped now; the other side then needs to win
+    // back more than that.
+    int swap = PIECE_VAL[victim] - threshold;
+    if (swap < 0) return false;                      // even an uncontested capture falls short
+    swap = PIECE_VAL[type_of(pos.piece_on(from))] - swap;
+    if (swap <= 0) return true;                      // losing the capturer still meets it
 
-    PieceType aPiece  = type_of(pos.piece_on(from));   // piece left standing on `to`
-    Bitboard  fromSet = square_bb(from);
-    Bitboard  occ     = pos.pieces();
+    Bitboard occ = pos.pieces() ^ square_bb(from);
     if (ep) occ ^= square_bb(Square(pos.side_to_move() == WHITE ? to - 8 : to + 8));
-
-    Color side = ~pos.side_to_move();        // side to recapture
-
+    const Bitboard diag = pos.pieces(BISHOP) | pos.pieces(QUEEN);
+    const Bitboard orth = pos.pieces(ROOK)   | pos.pieces(QUEEN);
+    Bitboard attackers  = pos.attackers_to(to, occ);
+    // A side's pins are only looked up once it has a recapture to make: most
+    // exchanges are decided before that.
+    Bitboard pinned[COLOR_NB], pinners[COLOR_NB];
+    bool     pinsKnown[COLOR_NB] = { false, false };
+
+    Color side = pos.side_to_move();
+    int   res  = 1;                                  // 1: the mover currently meets the threshold
     while (true) {
-        ++d;
-        gain[d] = PIECE_VAL[aPiece] - gain[d - 1];
-        if (std::max(-gain[d - 1], gain[d]) < 0) break;   // even optimistically losing
-
-        occ ^= fromSet;                                    // the capturer leaves its square
-        Bitboard attackers = pos.attackers_to(to, occ) & occ;
+        side = ~side;
+        attackers &= occ;
         Bitboard mine = attackers & pos.pieces(side);
         if (!mine) break;
-
-        PieceType pt = PAWN;                               // least valuable attacker
-        Bitboard sel = 0;
-        for (; pt <= KING; pt = PieceType(pt + 1)) {
-            sel = mine & pos.pieces(pt);
-            if (sel) break;
+        if (!pinsKnown[side]) {
+            king_pins(pos, side, pinned[side], pinners[side]);
+            pinsKnown[side] = true;
         }
-        if (pt == KING && (attackers & pos.pieces(~side)))
-            break;                                         // king can't recapture into check
-
-        fromSet = sel & (0ULL - sel);                      // one (lowest) attacker
-        aPiece  = pt;
-        side    = ~side;
+        if (pinners[side] & occ) mine &= ~pinned[side];
+        if (!mine) break;
+        res ^= 1;
+
+        // Capture with the least valuable attacker; a slider (or pawn, which
+        // captures diagonally) leaving can open the line behind it.
+        Bitboard bb;
+        if      ((bb = mine & pos.pieces(PAWN)))   { if ((swap = PIECE_VAL[PAWN] - swap) < res) break;
+                                                     occ ^= square_bb(lsb(bb));
+                                                     attackers |= bishop_attacks(to, occ) & diag; }
+        else if ((bb = mine & pos.pieces(KNIGHT))) { if ((swap = PIECE_VAL[KNIGHT] - swap) < res) break;
+                                                     occ ^= square_bb(lsb(bb)); }
+        else if ((bb = mine & pos.pieces(BISHOP))) { if ((swap = PIECE_VAL[BISHOP] - swap) < res) break;
+                                                     occ ^= square_bb(lsb(bb));
+                                                     attackers |= bishop_attacks(to, occ) & diag; }
+        else if ((bb = mine & pos.pieces(ROOK)))   { if ((swap = PIECE_VAL[ROOK] - swap) < res) break;
+                                                     occ ^= square_bb(lsb(bb));
+                                                     attackers |= rook_attacks(to, occ) & orth; }
+        else if ((bb = mine & pos.pieces(QUEEN)))  { if ((swap = PIECE_VAL[QUEEN] - swap) < res) break;
+                                                     occ ^= square_bb(lsb(bb));
+                                                     attackers |= (bishop_attacks(to, occ) & diag)
+                                                                | (rook_attacks(to, occ) & orth); }
+        else  // the king: it may only take if the other side has nothing left
+            return (attackers & occ & ~pos.pieces(side)) ? res ^ 1 : res;
     }
-
-    while (--d > 0)
-        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
-    return gain[0];
+    return bool(res);
 }
 
+namespace {
+
+// A worker's node count on a cache line of its own. Each counter has a single
+// writer (its worker) and is read by whoever needs the total, so padding keeps
+// one thread's counting from invalidating the line another thread writes.
+struct alignas(64) NodeCounter {
+    std::atomic<std::uint64_t> n{0};
+};
+
+// Budget checks against the all-thread total run every this many nodes per
+// worker (a single-threaded search checks its own count exactly, every node).
+constexpr std::uint64_t NODE_CHECK_INTERVAL = 1024;
+
 // ---- Shared state: injected (by reference) into every Worker -----------------
 struct SharedState {
     TranspositionTable&                tt;
     const SearchLimits&                limits;
     std::atomic<bool>&                 stop;        // external abort + helper halt
     const std::vector<std::uint64_t>&  gameHistory; // repetition seed (read-only)
+    const std::function<void(const SearchInfo&)>& onInfo;   // main worker's reports
+    // Pondering: while `pondering` is set the clock is not running (no time
+    // limit, and no bestmove before ponderhit/stop). On ponderhit the movetime
+    // budget starts counting `ponderhitMs` into the search.
+    std::atomic<bool>&                 pondering;
+    std::atomic<std::int64_t>&         ponderhitMs;
+    std::unique_ptr<NodeCounter[]>     nodeCounters{};   // one per worker
+    int                                threadCount = 0;
+
+    // Nodes searched by all workers so far (relaxed: a moment's staleness is fine).
+    std::uint64_t total_nodes() const {
+        std::uint64_t sum = 0;
+        for (int i = 0; i < threadCount; ++i) sum += nodeCounters[i].n.load(std::memory_order_relaxed);
+        return sum;
+    }
+};
+
+// One MultiPV line: a root move, its score and principal variation at the last
+// completed depth.
+struct RootLine {
+    Move              move  = MOVE_NONE;
+    int               score = 0;
+    std::vector<Move> pv;
 };
 
 // ---- The Worker: all per-thread state + the search ---------------------------
@@ -194,13 +236,38 @@ struct Worker {
     SharedState&  shared;
     Position      pos;                 // this thread's OWN copy of the root
     int           threadId;
-    std::uint64_t nodes = 0;
+    // This worker's slot in shared.nodeCounters. Written only by this thread
+    // (relaxed load + store, no locked RMW); read by anyone summing the total.
+    std::atomic<std::uint64_t>& nodes;
     bool          stop  = false;       // sticky local copy of the abort decision
     std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point lastProgress;   // main worker: last periodic info
+    int           selDepth = 0;        // deepest ply reached in the current iteration
+    // Static evaluations this search: by the backend, and answered lazily by
+    // the material+PSQT estimate (see evaluate_lazy). Summed into SearchResult.
+    std::uint64_t evals = 0, lazyEvals = 0;
 
     Move rootBest = MOVE_NONE;
     int  rootDepth = 1;          // depth of the current iterative-deepening iteration
 
+    // MultiPV: lines[k] is the best root move once lines[0..k-1] are excluded.
+    // pvIdx is the line being searched; the root skips the moves of lines before it.
+    std::vector<RootLine> lines;
+    int                   pvIdx = 0;
+
+    // Triangular PV table: pvTable[ply][ply..pvLength[ply]) is the best line
+    // found from the node at `ply`; a node that raises alpha prepends its move to
+    // its child's line. Row 0 is the root's PV.
+    Move pvTable[MAX_PLY][MAX_PLY];
+    int  pvLength[MAX_PLY] = {};
+
+    // PV following: the previous iteration's line for the PV being searched.
+    // onPv[ply] says the moves played so far all match it, in which case
+    // prevPv[ply] is searched first at that ply.
+    Move prevPv[MAX_PLY];
+    int  prevPvLength = 0;
+    bool onPv[MAX_PLY] = {};
+
     Move killers[MAX_PLY][2] = {};
     int  history[COLOR_NB][SQUARE_NB][SQUARE_NB] = {};
     // Counter-move heuristic: the quiet move that last refuted the opponent's
@@ -211,13 +278,47 @@ struct Worker {
     // path). Invariant: back() == pos.key() at every node. Used for repetitions.
     std::vector<std::uint64_t> repList;
 
-    Worker(SharedState& s, const Position& root, int id)
-        : shared(s), pos(root), threadId(id) {
-        if (shared.gameHistory.empty()) repList = { pos.key() };
+    Worker(SharedState& s, int id) : shared(s), threadId(id), nodes(s.nodeCounters[id].n) {}
+
+    // Reset for a new search from `root`. Workers live as long as their pool
+    // thread, so everything per-search is (re)initialized here, not in the ctor.
+    void prepare(const Position& root) {
+        pos       = root;
+        pos.invalidate_accumulator();   // NNUE: rebuilt for the current net; HCE: never maintained
+        nodes.store(0, std::memory_order_relaxed);
+        evals     = lazyEvals = 0;
+        stop      = false;
+        rootBest  = MOVE_NONE;
+        rootDepth = 1;
+        age_heuristics();
+        if (shared.gameHistory.empty()) repList.assign(1, pos.key());
         else                            repList = shared.gameHistory;
         repList.reserve(repList.size() + MAX_PLY + 4);   // no reallocation mid-search
     }
 
+    // The move-ordering tables outlive a search: the next move of the same game
+    // starts from what this one learned instead of from MVV-LVA alone. Between
+    // searches history is halved (fresh evidence soon outweighs stale), killers
+    // shift down two plies (our move and the reply have been played since), and
+    // counter-moves are kept as they are.
+    void age_heuristics() {
+        for (auto& side : history)
+            for (auto& from : side)
+                for (int& h : from) h /= 2;
+        for (int ply = 0; ply < MAX_PLY; ++ply)
+            for (int i = 0; i < 2; ++i)
+                killers[ply][i] = ply + 2 < MAX_PLY ? killers[ply + 2][i] : MOVE_NONE;
+    }
+
+    // Forget everything (new game).
+    void clear_heuristics() {
+        for (auto& k : killers) k[0] = k[1] = MOVE_NONE;
+        std::memset(history, 0, sizeof(history));
+        for (auto& side : counterMove)
+            for (auto& from : side)
+                std::fill(std::begin(from), std::end(from), MOVE_NONE);
+    }
+
     // Draw by the 50-move rule or by repetition. In search a single repetition is
     // treated as a draw (if we can repeat once we can repeat again).
     bool is_draw() const {
@@ -230,15 +331,97 @@ struct Worker {
         return false;
     }
 
+    std::uint64_t node_count() const { return nodes.load(std::memory_order_relaxed); }
+
+    // Count a visited node and note how deep this line has gone.
+    void count_node(int ply) {
+        nodes.store(node_count() + 1, std::memory_order_relaxed);
+        selDepth = std::max(selDepth, ply + 1);
+    }
+
+    // The static eval, lazily for the window [alpha, beta] (-INF, INF: never lazy).
+    template <class Eval>
+    int static_eval(int alpha, int beta, bool& lazy) {
+        const int v = evaluate_lazy<Eval>(pos, alpha, beta, lazy);
+        ++(lazy ? lazyEvals : evals);
+        return v;
+    }
+
+    std::int64_t elapsed_ms() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - start).count();
+    }
+
     bool out_of_time() {
         if (stop) return true;
         if (shared.stop.load(std::memory_order_relaxed)) { stop = true; return true; }
-        if (shared.limits.max_nodes && nodes >= shared.limits.max_nodes) { stop = true; return true; }
-        if (shared.limits.movetime_ms > 0 && (nodes & 2047) == 0) {
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          std::chrono::steady_clock::now() - start).count();
-            if (ms >= shared.limits.movetime_ms) { stop = true; return true; }
+        const std::uint64_t n = node_count();
+        // The node budget is global: with Lazy SMP it bounds the total over all
+        // threads, not each thread's share.
+        if (shared.limits.max_nodes) {
+            if (shared.threadCount == 1 ? n >= shared.limits.max_nodes
+                                        : (n % NODE_CHECK_INTERVAL == 0
+                                           && shared.total_nodes() >= shared.limits.max_nodes)) {
+                stop = true;
+                return true;
+            }
+        }
+        if (shared.limits.movetime_ms > 0 && (n & 2047) == 0
+            && !shared.pondering.load(std::memory_order_acquire)) {
+            const std::int64_t onClock = elapsed_ms() - shared.ponderhitMs.load(std::memory_order_relaxed);
+            if (onClock >= shared.limits.movetime_ms) { stop = true; return true; }
         }
+        if (threadId == 0 && (n & 4095) == 0 && shared.onInfo) report_progress();
+        return false;
+    }
+
+    // ---- Progress reports (main worker only) -------------------------------
+
+    // The fields every report shares: depth, seldepth, nodes summed over all
+    // workers, elapsed time, TT occupancy.
+    SearchInfo make_info(SearchInfo::Kind kind) const {
+        SearchInfo i;
+        i.kind     = kind;
+        i.depth    = rootDepth;
+        i.seldepth = selDepth;
+        i.nodes    = shared.total_nodes();
+        i.time_ms  = elapsed_ms();
+        i.hashfull = shared.tt.hashfull();
+        return i;
+    }
+
+    // A line report: a completed line (BOUND_EXACT), or an aspiration fail-high
+    // (BOUND_LOWER) / fail-low (BOUND_UPPER) about to be re-searched.
+    void report_line(int multipv, int score, Bound bound, const std::vector<Move>& pv) const {
+        SearchInfo i = make_info(SearchInfo::LINE);
+        i.multipv = multipv;
+        i.score   = score;
+        i.bound   = bound;
+        i.pv      = pv;
+        shared.onInfo(i);
+    }
+
+    // Periodic nodes/nps/hashfull while a long iteration runs (about once a
+    // second, checked every 4096 nodes).
+    void report_progress() {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - start < std::chrono::seconds(1) || now - lastProgress < std::chrono::seconds(1))
+            return;
+        lastProgress = now;
+        shared.onInfo(make_info(SearchInfo::PROGRESS));
+    }
+
+    // `m` raised alpha at `ply`: the node's PV becomes m + the child's PV.
+    void update_pv(int ply, Move m) {
+        pvTable[ply][ply] = m;
+        const int childLen = std::max(ply + 1, pvLength[ply + 1]);
+        for (int i = ply + 1; i < childLen; ++i) pvTable[ply][i] = pvTable[ply + 1][i];
+        pvLength[ply] = childLen;
+    }
+
+    bool excluded_at_root(Move m) const {
+        for (int i = 0; i < pvIdx; ++i)
+            if (lines[i].move == m) return true;
         return false;
     }
 
@@ -246,7 +429,8 @@ struct Worker {
         return m.type_of() == EN_PASSANT || p.piece_on(m.to_sq()) != NO_PIECE;
     }
 
-    int score_move(Move m, Move ttMove, Move prevMove, int ply, Color us) const {
+    int score_move(Move m, Move ttMove, Move prevMove, int ply, Color us, Move pvMove) const {
+        if (m == pvMove) return 2'100'000;
         if (m == ttMove) return 2'000'000;
         Piece victim = (m.type_of() == EN_PASSANT) ? make_piece(~us, PAWN)
                                                    : pos.piece_on(m.to_sq());
@@ -258,7 +442,7 @@ struct Worker {
             // material by SEE sort behind every quiet move.
             if (PIECE_VAL[attacker] <= PIECE_VAL[type_of(victim)])
                 return 1'000'000 + mvvlva;
-            return (see(pos, m) >= 0 ? 1'000'000 : -1'000'000) + mvvlva;
+            return (see_ge(pos, m, 0) ? 1'000'000 : -1'000'000) + mvvlva;
         }
         if (m.type_of() == PROMOTION) return 900'000 + PIECE_VAL[m.promotion_type()];
         if (m == killers[ply][0])     return 800'000;
@@ -269,10 +453,12 @@ struct Worker {
     }
 
     // Sort the list in place, best move first (insertion sort; lists are small).
-    void order_moves(MoveList& list, Move ttMove, Move prevMove, int ply, Color us) {
+    // scores[i] is left holding list[i]'s ordering score, so callers can reuse
+    // what it encodes (e.g. the SEE verdict on a capture) without recomputing it.
+    void order_moves(MoveList& list, int* scores, Move ttMove, Move prevMove, int ply, Color us,
+                     Move pvMove = MOVE_NONE) {
         const int n = list.size();
-        int scores[MoveList::CAPACITY];
-        for (int i = 0; i < n; ++i) scores[i] = score_move(list[i], ttMove, prevMove, ply, us);
+        for (int i = 0; i < n; ++i) scores[i] = score_move(list[i], ttMove, prevMove, ply, us, pvMove);
         for (int i = 1; i < n; ++i) {
             Move m = list[i];
             int  sc = scores[i], j = i - 1;
@@ -283,58 +469,126 @@ struct Worker {
         }
     }
 
+    template <class Eval>
     int quiesce(int alpha, int beta, int ply) {
+        pvLength[ply] = ply;                         // quiescence lines are not reported
         if (out_of_time()) return 0;
-        ++nodes;
+        count_node(ply);
 
-        int standPat = evaluate(pos);
-        if (standPat >= beta) return beta;
-        if (standPat > alpha) alpha = standPat;
-        if (ply >= MAX_PLY - 1) return alpha;
-
-        MoveList moves;
-        generate_legal_captures(pos, moves);   // captures, en passant, promotions only
-        order_moves(moves, MOVE_NONE, MOVE_NONE, ply, pos.side_to_move());
-
-        for (Move m : moves) {
+        // Transposition table probe. Quiescence is depth 0, so any entry for this
+        // position is deep enough to cut on; otherwise its move is tried first.
+        bool ttHit;
+        TTEntry* tte = shared.tt.probe(pos.key(), ttHit);
+        Move  ttMove  = MOVE_NONE;
+        int   ttScore = 0;
+        int   ttEval  = 0;
+        Bound ttBound = BOUND_NONE;
+        if (ttHit) {
+            ttMove  = tte->move;
+            ttScore = from_tt(tte->score, ply);
+            ttEval  = tte->eval;
+            ttBound = Bound(tte->bound);
+            if (ttBound == BOUND_EXACT) return ttScore;
+            if (ttBound == BOUND_LOWER && ttScore >= beta)  return ttScore;
+            if (ttBound == BOUND_UPPER && ttScore <= alpha) return ttScore;
+        }
+        const int origAlpha = alpha;
 
-            // Delta pruning: if winning this piece (plus a margin) still can't
-            // reach alpha, the capture is hopeless - skip it.
-            PieceType victim = (m.type_of() == EN_PASSANT) ? PAWN
-                                                           : type_of(pos.piece_on(m.to_sq()));
-            int gain = PIECE_VAL[victim] + (m.type_of() == PROMOTION ? 800 : 0);
-            if (standPat + gain + 100 < alpha) continue;
+        // In check there is no standing pat: every evasion is searched (quiet
+        // ones included), and having none is mate. The stand-pat score is the
+        // static eval (taken from the TT entry when there is one), raised to the
+        // TT score when that is a lower bound above it.
+        const bool inCheck = pos.in_check();
+        bool lazy = false;
+        const int  staticEval = inCheck ? -INF
+                              : ttHit && ttEval != EVAL_NONE ? ttEval
+                              : static_eval<Eval>(alpha, beta, lazy);
+        const int  ttEvalOut  = lazy ? EVAL_NONE : staticEval;   // an estimate is not stored
+        int standPat = staticEval;
+        if (!inCheck) {
+            if (ttBound == BOUND_LOWER && ttScore > standPat) standPat = ttScore;
+            if (standPat >= beta) {
+                qstore(MOVE_NONE, standPat, BOUND_LOWER, ttEvalOut, ply);
+                return beta;
+            }
+            if (standPat > alpha) alpha = standPat;
+        }
+        if (ply >= MAX_PLY - 1) return inCheck ? 0 : alpha;
 
-            // Skip captures that lose material by static exchange evaluation.
-            if (is_capture(pos, m) && see(pos, m) < 0) continue;
+        MoveList moves;
+        if (inCheck) generate_legal<EVASIONS>(pos, moves);
+        else         generate_legal_captures(pos, moves);   // captures, en passant, promotions only
+        if (inCheck && moves.size() == 0) return -MATE + ply;
+        int scores[MoveList::CAPACITY];
+        order_moves(moves, scores, ttMove, MOVE_NONE, ply, pos.side_to_move());
+
+        Move bestMove = MOVE_NONE;
+        for (int i = 0; i < moves.size(); ++i) {
+            const Move m = moves[i];
+            if (!inCheck) {
+                // Delta pruning: if winning this piece (plus a margin) still can't
+                // reach alpha, the capture is hopeless - skip it.
+                PieceType victim = (m.type_of() == EN_PASSANT) ? PAWN
+                                                               : type_of(pos.piece_on(m.to_sq()));
+                int gain = PIECE_VAL[victim] + (m.type_of() == PROMOTION ? 800 : 0);
+                if (standPat + gain + 100 < alpha) continue;
+
+                // Skip captures that lose material by static exchange evaluation.
+                // Ordering already ran SEE (losing captures are the negative
+                // scores) for every move but the TT move, whose score only
+                // says "first" - so it gets its own check.
+                const bool seeOk = m == ttMove ? see_ge(pos, m, 0) : scores[i] >= 0;
+                if (!seeOk) continue;
+            }
 
             Position::Undo u;
             pos.make_move(m, u);
-            int score = -quiesce(-beta, -alpha, ply + 1);
+            int score = -quiesce<Eval>(-beta, -alpha, ply + 1);
             pos.unmake_move(m, u);
             if (stop) return 0;
-            if (score >= beta) return beta;
-            if (score > alpha) alpha = score;
+            if (score >= beta) {
+                qstore(m, beta, BOUND_LOWER, ttEvalOut, ply);
+                return beta;
+            }
+            if (score > alpha) { alpha = score; bestMove = m; }
         }
+        qstore(bestMove, alpha, alpha > origAlpha ? BOUND_EXACT : BOUND_UPPER, ttEvalOut, ply);
         return alpha;
     }
 
+    // Store a quiescence result (depth 0). The slot is re-probed because the
+    // child searches may have reused it; an entry from the main search for the
+    // same position is deeper and is kept.
+    void qstore(Move m, int score, Bound bound, int staticEval, int ply) {
+        bool hit;
+        TTEntry* tte = shared.tt.probe(pos.key(), hit);
+        if (hit && tte->depth > 0) return;
+        *tte = TTEntry{ pos.key(), m, static_cast<std::int16_t>(to_tt(score, ply)),
+                        0, static_cast<std::uint8_t>(bound),
+                        static_cast<std::int16_t>(staticEval) };
+    }
+
+    template <class Eval>
     int negamax(int depth, int alpha, int beta, int ply, Move prevMove,
                 Move excludedMove = MOVE_NONE) {
+        // A singular verification search shares this ply with its parent node
+        // and must not clobber the PV that node has built so far.
+        if (excludedMove == MOVE_NONE) pvLength[ply] = ply;
         if (out_of_time()) return 0;
-        ++nodes;
+        count_node(ply);
 
         if (ply > 0 && is_draw()) return 0;          // repetition / 50-move = draw
 
         const bool root    = (ply == 0);
         const bool inCheck = pos.in_check();
+        if (ply >= MAX_PLY - 1) return inCheck ? 0 : Eval::evaluate(pos);
         // Check extension, but cap how far a line may run past the nominal depth.
         // Unbounded check extensions let forcing check sequences (common in winning
         // positions) blow up the tree - the likely cause of a normally-20s move
         // taking minutes. Stop extending once we're already deep past the root.
         if (inCheck && ply < 2 * rootDepth) ++depth;
 
-        if (depth <= 0) return quiesce(alpha, beta, ply);
+        if (depth <= 0) return quiesce<Eval>(alpha, beta, ply);
 
         // Transposition table probe.
         bool ttHit;
@@ -343,18 +597,22 @@ struct Worker {
         // the child searches below probe/store the shared table and may overwrite
         // the slot `tte` points at, so anything we need after a recursive call must
         // be read here, up front.
+        const bool pvNode = (beta - alpha) > 1;
         Move  ttMove  = MOVE_NONE;
         int   ttScore = 0;
         int   ttDepth = 0;
+        int   ttEval  = 0;
         Bound ttBound = BOUND_NONE;
         if (ttHit) {
             ttMove  = tte->move;
             ttScore = from_tt(tte->score, ply);
             ttDepth = tte->depth;
+            ttEval  = tte->eval;
             ttBound = Bound(tte->bound);
             // No TT cutoff while verifying singularity (the stored entry includes
-            // the move we are trying to exclude).
-            if (!root && excludedMove == MOVE_NONE && ttDepth >= depth) {
+            // the move we are trying to exclude), nor at PV nodes: the cut would
+            // leave the PV ending here instead of the full line being reported.
+            if (!pvNode && excludedMove == MOVE_NONE && ttDepth >= depth) {
                 if (ttBound == BOUND_EXACT) return ttScore;
                 if (ttBound == BOUND_LOWER && ttScore >= beta)  return ttScore;
                 if (ttBound == BOUND_UPPER && ttScore <= alpha) return ttScore;
@@ -362,8 +620,15 @@ struct Worker {
         }
 
         const Color us         = pos.side_to_move();
-        const bool  pvNode     = (beta - alpha) > 1;
-        const int   staticEval = inCheck ? -INF : evaluate(pos);
+        // The static eval comes from the TT entry when there is one, so a
+        // transposition skips the evaluation (for NNUE, the accumulator update
+        // and forward pass). Off the PV it is only used by the futility tests
+        // below, so it may be lazy there.
+        bool lazy = false;
+        const int   staticEval = inCheck ? -INF
+                               : ttHit && ttEval != EVAL_NONE ? ttEval
+                               : pvNode ? static_eval<Eval>(-INF, INF, lazy)
+                                        : static_eval<Eval>(alpha, beta, lazy);
 
         // Reverse futility pruning (static null move): if our static eval is so
         // far above beta that even a generous margin can't pull it under, prune.
@@ -380,7 +645,8 @@ struct Worker {
             Position::Undo u;
             pos.make_null_move(u);
             repList.push_back(pos.key());
-            int score = -negamax(depth - 1 - R, -beta, -beta + 1, ply + 1, MOVE_NONE);
+            onPv[ply + 1] = false;
+            int score = -negamax<Eval>(depth - 1 - R, -beta, -beta + 1, ply + 1, MOVE_NONE);
             repList.pop_back();
             pos.unmake_null_move(u);
             if (stop) return 0;
@@ -392,7 +658,9 @@ struct Worker {
         if (moves.size() == 0)                       // checkmate or stalemate
             return inCheck ? -MATE + ply : 0;
 
-        order_moves(moves, ttMove, prevMove, ply, us);
+        const Move pvMove = (onPv[ply] && ply < prevPvLength) ? prevPv[ply] : MOVE_NONE;
+        int scores[MoveList::CAPACITY];
+        order_moves(moves, scores, ttMove, prevMove, ply, us, pvMove);
 
         int  bestScore = -INF;
         Move bestMove  = MOVE_NONE;
@@ -401,8 +669,17 @@ struct Worker {
 
         for (Move m : moves) {
             if (m == excludedMove) continue;   // verifying singularity: skip it
+            if (root && excluded_at_root(m)) continue;   // taken by an earlier PV line
             ++moveCount;
 
+            // On long iterations, tell the GUI which root move is being searched.
+            if (root && threadId == 0 && shared.onInfo && elapsed_ms() >= CURRMOVE_AFTER_MS) {
+                SearchInfo i = make_info(SearchInfo::CURRMOVE);
+                i.currmove       = m;
+                i.currmovenumber = moveCount + pvIdx;
+                shared.onInfo(i);
+            }
+
             // Singular extension: if the TT move is much better than every
             // alternative, follow it one ply deeper. We prove it by re-searching
             // this node at reduced depth, EXCLUDING the TT move, with a window just
@@ -415,7 +692,7 @@ struct Worker {
                 && std::abs(ttScore) < MATE_IN_MAX) {
                 const int singularBeta  = ttScore - 3 * depth;
                 const int singularDepth = (depth - 1) / 2;
-                int s = negamax(singularDepth, singularBeta - 1, singularBeta,
+                int s = negamax<Eval>(singularDepth, singularBeta - 1, singularBeta,
                                 ply, prevMove, /*excludedMove=*/ttMove);
                 if (s < singularBeta) extension = 1;
             }
@@ -442,12 +719,13 @@ struct Worker {
             }
 
             repList.push_back(pos.key());
+            onPv[ply + 1] = onPv[ply] && m == pvMove;
 
             const int newDepth = depth - 1 + extension;   // singular extension folds in here
 
             int score;
             if (moveCount == 1) {
-                score = -negamax(newDepth, -beta, -alpha, ply + 1, m);   // PV: full window
+                score = -negamax<Eval>(newDepth, -beta, -alpha, ply + 1, m);   // PV: full window
             } else {
                 int R = 0;  // late move reduction for quiet, non-checking moves
                 if (depth >= 3 && moveCount > 3 && quiet && !givesCheck && !inCheck) {
@@ -456,11 +734,11 @@ struct Worker {
                     R = std::max(0, std::min(R, depth - 2));
                 }
 
-                score = -negamax(newDepth - R, -alpha - 1, -alpha, ply + 1, m);  // reduced null window
+                score = -negamax<Eval>(newDepth - R, -alpha - 1, -alpha, ply + 1, m);  // reduced null window
                 if (score > alpha && R > 0)
-                    score = -negamax(newDepth, -alpha - 1, -alpha, ply + 1, m);  // re-search full depth
+                    score = -negamax<Eval>(newDepth, -alpha - 1, -alpha, ply + 1, m);  // re-search full depth
                 if (score > alpha && score < beta)
-                    score = -negamax(newDepth, -beta, -alpha, ply + 1, m);       // re-search full window
+                    score = -negamax<Eval>(newDepth, -beta, -alpha, ply + 1, m);       // re-search full window
             }
 
             repList.pop_back();
@@ -472,7 +750,10 @@ struct Worker {
                 bestMove  = m;
                 if (root) rootBest = m;
             }
-            if (score > alpha) alpha = score;
+            if (score > alpha) {
+                alpha = score;
+                if (excludedMove == MOVE_NONE) update_pv(ply, m);
+            }
             if (alpha >= beta) {                     // beta cutoff
                 if (!capture) {                      // remember good quiet moves
                     if (!(killers[ply][0] == m)) {
@@ -495,111 +776,341 @@ struct Worker {
         Bound flag = (bestScore <= origAlpha) ? BOUND_UPPER
                    : (bestScore >= beta)       ? BOUND_LOWER
                                                : BOUND_EXACT;
-        // Skip the store during a singular verification search: its result is a
-        // partial value for a node with one move removed, not the true node score.
-        if (excludedMove == MOVE_NONE
+        // Skip the store during a singular verification search or a later MultiPV
+        // line: the result is a partial value for a node with moves removed, not
+        // the true node score.
+        if (excludedMove == MOVE_NONE && !(root && pvIdx > 0)
             && (tte->key != pos.key() || depth >= tte->depth || flag == BOUND_EXACT))
             *tte = TTEntry{ pos.key(), bestMove,
                             static_cast<std::int16_t>(to_tt(bestScore, ply)),
-                            static_cast<std::int8_t>(depth), static_cast<std::uint8_t>(flag) };
+                            static_cast<std::int8_t>(depth), static_cast<std::uint8_t>(flag),
+                            static_cast<std::int16_t>(lazy ? EVAL_NONE : staticEval) };
         return bestScore;
     }
 
+    // The search result is the best-first line list's head.
+    void set_result(SearchResult& result, int depth) const {
+        result.best  = lines[0].move;
+        result.score = lines[0].score;
+        result.depth = depth;
+        result.pv    = lines[0].pv;
+    }
+
     // Iterative deepening for this worker. The main worker (threadId 0) drives
-    // the time/depth budget; helper workers loop to the same max depth and exit
-    // when the shared stop flag is raised by the main worker (or the user).
+    // the time/depth budget and reports each completed depth; helper workers
+    // loop to the same max depth and exit when the shared stop flag is raised by
+    // the main worker (or the user).
+    //
+    // MultiPV: each depth searches limits.multipv lines in turn, line k with the
+    // moves of lines 0..k-1 excluded at the root. Every line after the first
+    // re-walks a tree the first one just filled the TT for, so N lines cost far
+    // less than N separate searches.
+    //
+    // Eval (HceEval / NnueEval, chosen once per search by SearchEngine::start) is
+    // the evaluation the whole recursion is compiled against.
+    template <class Eval>
     SearchResult go() {
-        start = std::chrono::steady_clock::now();
+        start = lastProgress = std::chrono::steady_clock::now();
         SearchResult result;
-        int prevScore = 0;
+
+        MoveList legal;
+        generate_legal(pos, legal);
+        const int multiPV = std::clamp(shared.limits.multipv, 1, std::max(1, legal.size()));
+        lines.assign(multiPV, RootLine{});
 
         for (int d = 1; d <= shared.limits.depth && d < MAX_PLY; ++d) {
-            rootBest  = MOVE_NONE;
             rootDepth = d;
+            selDepth  = 0;
+
+            for (pvIdx = 0; pvIdx < multiPV; ++pvIdx) {
+                rootBest = MOVE_NONE;
+                const int prevScore = lines[pvIdx].score;
+                prevPvLength = int(lines[pvIdx].pv.size());
+                std::copy(lines[pvIdx].pv.begin(), lines[pvIdx].pv.end(), prevPv);
+
+                int alpha = -INF, beta = INF, window = 25;
+                if (d >= 4) { alpha = prevScore - window; beta = prevScore + window; }
+
+                int score;
+                int fails = 0;
+                while (true) {                        // aspiration window with widening
+                    onPv[0] = true;
+                    score = negamax<Eval>(d, alpha, beta, 0, MOVE_NONE);
+                    if (stop) break;
+                    // Widen only the bound that failed (the other stays tight). After
+                    // a couple of failures, or once near mate, open that side fully -
+                    // doubling forever on an unstable score re-searches the whole
+                    // tree many times (the cause of pathological slowdowns).
+                    if (threadId == 0 && shared.onInfo && (score <= alpha || score >= beta)) {
+                        const bool low = score <= alpha;
+                        const std::vector<Move> pv = (low || pvLength[0] == 0)
+                            ? lines[pvIdx].pv : std::vector<Move>(pvTable[0], pvTable[0] + pvLength[0]);
+                        report_line(pvIdx + 1, score, low ? BOUND_UPPER : BOUND_LOWER, pv);
+                    }
+                    if (score <= alpha) {
+                        window *= 2;
+                        alpha = (++fails >= 2 || std::abs(score) >= MATE_IN_MAX)
+                                    ? -INF : std::max(-INF, score - window);
+                    } else if (score >= beta) {
+                        window *= 2;
+                        beta = (++fails >= 2 || std::abs(score) >= MATE_IN_MAX)
+                                    ? INF : std::min(INF, score + window);
+                    } else {
+                        break;
+                    }
+                }
 
-            int alpha = -INF, beta = INF, window = 25;
-            if (d >= 4) { alpha = prevScore - window; beta = prevScore + window; }
+                if (stop) break;                      // discard an incomplete line
 
-            int score;
-            int fails = 0;
-            while (true) {                            // aspiration window with widening
-                score = negamax(d, alpha, beta, 0, MOVE_NONE);
-                if (stop) break;
-                // Widen only the bound that failed (the other stays tight). After a
-                // couple of failures, or once near mate, open that side fully -
-                // doubling forever on an unstable score re-searches the whole tree
-                // many times (the cause of pathological slowdowns).
-                if (score <= alpha) {
-                    window *= 2;
-                    alpha = (++fails >= 2 || std::abs(score) >= MATE_IN_MAX)
-                                ? -INF : std::max(-INF, score - window);
-                } else if (score >= beta) {
-                    window *= 2;
-                    beta = (++fails >= 2 || std::abs(score) >= MATE_IN_MAX)
-                                ? INF : std::min(INF, score + window);
-                } else {
-                    break;
-                }
+                RootLine& line = lines[pvIdx];
+                line.move  = rootBest;
+                line.score = score;
+                line.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+                if (line.pv.empty() || line.pv[0] != rootBest) line.pv.assign(1, rootBest);
             }
 
-            if (stop) break;                          // discard an incomplete depth
+            if (stop) break;                          // a partial depth is not reported
 
-            result.best  = rootBest;
-            result.score = score;
-            result.depth = d;
-            result.nodes = nodes;
-            prevScore    = score;
+            // Later lines can out-score earlier ones (search instability); keep the
+            // list best-first for the report and the next depth's windows.
+            std::stable_sort(lines.begin(), lines.end(),
+                             [](const RootLine& a, const RootLine& b) { return a.score > b.score; });
+            if (threadId == 0 && shared.onInfo)
+                for (int k = 0; k < multiPV; ++k)
+                    report_line(k + 1, lines[k].score, BOUND_EXACT, lines[k].pv);
+            set_result(result, d);                    // bestmove == the reported line 1
 
-            if (score >= MATE_IN_MAX || score <= -MATE_IN_MAX) break;  // mate found
+            const int best = lines[0].score;
+            if (multiPV == 1 && (best >= MATE_IN_MAX || best <= -MATE_IN_MAX)) break;  // mate found
             if (out_of_time()) break;
         }
+
+        // Stopped before any depth completed: the first line, if it finished,
+        // still beats no move at all.
+        if (result.best == MOVE_NONE && lines[0].move != MOVE_NONE) set_result(result, rootDepth);
+
+        // UCI forbids a bestmove while pondering: a search that finished early
+        // (depth limit, mate found) holds its result until ponderhit or stop.
+        if (threadId == 0)
+            while (shared.pondering.load(std::memory_order_acquire)
+                   && !shared.stop.load(std::memory_order_relaxed))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
         return result;
     }
 };
 
+// Bind the calling thread to one logical CPU (best effort; ignored where the
+// platform has no API for it). Keeps each search thread's caches warm across
+// moves instead of letting the scheduler migrate it.
+void pin_to_cpu(int cpu) {
+#if defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (cpu % (8 * sizeof(DWORD_PTR))));
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+// One long-lived search thread. It sleeps until start() hands it a job, runs
+// it, and goes back to sleep; wait_idle() blocks until the current job is done.
+class SearchThread {
+public:
+    SearchThread(SharedState& shared, int id, bool pin)
+        : worker(shared, id), pin_(pin), thread_(&SearchThread::idle_loop, this) {}
+
+    ~SearchThread() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            exit_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void start(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            job_  = std::move(job);
+            busy_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void wait_idle() {
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [&] { return !busy_; });
+    }
+
+    Worker worker;
+
+private:
+    void idle_loop() {
+        if (pin_) pin_to_cpu(worker.threadId);
+        std::unique_lock<std::mutex> lk(m_);
+        while (true) {
+            cv_.wait(lk, [&] { return busy_ || exit_; });
+            if (exit_) return;
+            std::function<void()> job = std::move(job_);
+            lk.unlock();
+            job();
+            lk.lock();
+            busy_ = false;
+            cv_.notify_all();
+        }
+    }
+
+    bool                    pin_;
+    std::mutex              m_;
+    std::condition_variable cv_;
+    std::function<void()>   job_;
+    bool                    busy_ = false;
+    bool                    exit_ = false;
+    std::thread             thread_;   // last: starts running once the rest is built
+};
+
 } // namespace
 
-SearchResult search(Position& pos, const SearchLimits& limits,
-                    const std::vector<std::uint64_t>& history) {
-    // NOTE: does NOT clear g_stop (the caller clear_stop()s on the controlling
-    // thread) and does NOT clear the TT - entries are validated by key, so they
-    // are reused across moves within a game (clear only on ucinewgame).
-    SharedState shared{ g_tt, limits, g_stop, history };
-
-    const int nThreads = std::max(1, limits.threads);
-    if (nThreads == 1) {
-        Worker w(shared, pos, 0);
-        return w.go();
+// The SearchEngine's threads and the SharedState they see. Thread 0 runs the
+// main worker (which owns the time/depth budget and the reported result); the
+// rest run Lazy SMP helpers.
+struct ThreadPool {
+    SharedState                                shared;
+    std::vector<std::unique_ptr<SearchThread>> threads;
+
+    ThreadPool(TranspositionTable& tt, const SearchLimits& limits, std::atomic<bool>& stop,
+               const std::vector<std::uint64_t>& history,
+               const std::function<void(const SearchInfo&)>& onInfo,
+               std::atomic<bool>& pondering, std::atomic<std::int64_t>& ponderhitMs, int n, bool pin)
+        : shared{ tt, limits, stop, history, onInfo, pondering, ponderhitMs } {
+        shared.nodeCounters = std::make_unique<NodeCounter[]>(std::size_t(n));
+        shared.threadCount  = n;
+        for (int i = 0; i < n; ++i)
+            threads.push_back(std::make_unique<SearchThread>(shared, i, pin));
+    }
+};
+
+SearchEngine::SearchEngine(std::size_t hashMb) : tt_(hashMb) { set_threads(1); }
+
+SearchEngine::~SearchEngine() {
+    stop();
+    wait();
+}
+
+void SearchEngine::set_threads(int n, bool pin) {
+    wait();
+    n = std::max(1, n);
+    if (pool_ && int(pool_->threads.size()) == n && pin_ == pin) return;
+    pool_.reset();   // joins the old threads before the new ones start
+    pin_  = pin;
+    pool_ = std::make_unique<ThreadPool>(tt_, limits_, stop_, history_, onInfo_,
+                                         pondering_, ponderhitMs_, n, pin);
+}
+
+void SearchEngine::start(const Position& pos, const SearchLimits& limits,
+                         const std::vector<std::uint64_t>& history,
+                         std::function<void(const SearchResult&)> onDone,
+                         std::function<void(const SearchInfo&)> onInfo) {
+    wait();                                  // one search at a time
+    if (int(pool_->threads.size()) != std::max(1, limits.threads))
+        set_threads(limits.threads, pin_);
+
+    limits_  = limits;
+    history_ = history;
+    onInfo_  = std::move(onInfo);
+    startTime_ = std::chrono::steady_clock::now();
+    ponderhitMs_.store(0, std::memory_order_relaxed);
+    pondering_.store(limits.ponder, std::memory_order_release);
+    for (auto& t : pool_->threads) t->worker.prepare(pos);
+
+    // Lazy SMP: N workers search the same root, sharing only the TT. Each has its
+    // own Position copy + history tables; their natural divergence (via TT
+    // contention and timing) widens the tree. Thread 0 wakes the helpers, runs
+    // the main worker, then halts and waits for them before reporting.
+    // The backend is fixed for the whole search: every worker runs the search
+    // instantiation for it.
+    const bool useNnue = nnue::is_loaded();
+    if (useNnue != ttNnue_) {                // the TT's static evals are the other backend's
+        tt_.clear();
+        ttNnue_ = useNnue;
     }
+    auto run = [useNnue](Worker& w) {
+        return useNnue ? w.go<NnueEval>() : w.go<HceEval>();
+    };
+
+    ThreadPool& pool = *pool_;
+    pool.threads[0]->start([this, &pool, run, onDone = std::move(onDone)] {
+        for (std::size_t i = 1; i < pool.threads.size(); ++i) {
+            Worker& w = pool.threads[i]->worker;
+            pool.threads[i]->start([&w, run] { run(w); });
+        }
+
+        result_ = run(pool.threads[0]->worker);   // main worker drives the budget
 
-    // Lazy SMP: N workers search the same root, sharing only the TT. Each helper
-    // gets its own Position copy + history tables; their natural divergence (via
-    // TT contention and timing) widens the tree. Helpers run on background
-    // threads; the main worker runs here and owns the reported result.
-    std::vector<std::unique_ptr<Worker>> workers;
-    workers.reserve(nThreads);
-    for (int i = 0; i < nThreads; ++i)
-        workers.push_back(std::make_unique<Worker>(shared, pos, i));
+        if (pool.threads.size() > 1) {
+            stop_.store(true, std::memory_order_relaxed);    // halt helpers...
+            for (std::size_t i = 1; i < pool.threads.size(); ++i) pool.threads[i]->wait_idle();
+            stop_.store(false, std::memory_order_relaxed);   // ...then disarm (we stopped them, not the user)
+        }
+        result_.nodes = pool.shared.total_nodes();      // every thread's work, partial depth included
+        for (auto& t : pool.threads) {                  // all idle now: plain reads are safe
+            result_.evals     += t->worker.evals;
+            result_.lazyEvals += t->worker.lazyEvals;
+        }
+        if (onDone) onDone(result_);
+    });
+}
 
-    std::vector<std::thread> helpers;
-    helpers.reserve(nThreads - 1);
-    for (int i = 1; i < nThreads; ++i)
-        helpers.emplace_back([&w = *workers[i]] { w.go(); });
+void SearchEngine::ponderhit() {
+    if (!pondering_.load(std::memory_order_acquire)) return;   // no ponder search running
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - startTime_).count();
+    ponderhitMs_.store(ms, std::memory_order_relaxed);
+    pondering_.store(false, std::memory_order_release);   // publishes ponderhitMs_
+}
 
-    SearchResult result = workers[0]->go();   // main worker drives the budget
+void SearchEngine::wait() {
+    if (pool_) pool_->threads[0]->wait_idle();
+}
 
-    g_stop.store(true, std::memory_order_relaxed);   // halt helpers...
-    for (auto& t : helpers) t.join();
-    g_stop.store(false, std::memory_order_relaxed);  // ...then disarm (we stopped them, not the user)
+SearchResult SearchEngine::search(Position& pos, const SearchLimits& limits,
+                                  const std::vector<std::uint64_t>& history) {
+    start(pos, limits, history);
+    wait();
+    return result_;
+}
 
-    return result;
+void SearchEngine::clear() {
+    wait();
+    tt_.clear();
+    for (auto& t : pool_->threads) t->worker.clear_heuristics();
+}
+
+void SearchEngine::resize_tt(std::size_t mb) { tt_.resize(std::max<std::size_t>(1, mb)); }
+
+// ---- Process-wide engine ------------------------------------------------------
+
+namespace {
+// Constructed on first use, so it never depends on static-init order.
+SearchEngine& default_engine() {
+    static SearchEngine engine;
+    return engine;
+}
+} // namespace
+
+SearchResult search(Position& pos, const SearchLimits& limits,
+                    const std::vector<std::uint64_t>& history) {
+    return default_engine().search(pos, limits, history);
 }
 
-void tt_clear() { g_tt.clear(); }
+void tt_clear() { default_engine().clear(); }
 
-void tt_resize(int mb) { g_tt.resize(static_cast<std::size_t>(std::max(1, mb))); }
+void tt_resize(int mb) { default_engine().resize_tt(static_cast<std::size_t>(std::max(1, mb))); }
 
-void stop_search()  { g_stop.store(true,  std::memory_order_relaxed); }
-void clear_stop()   { g_stop.store(false, std::memory_order_relaxed); }
+void stop_search()  { default_engine().stop(); }
+void clear_stop()   { default_engine().clear_stop(); }
 
 } // namespace chess
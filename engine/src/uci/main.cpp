@@ -1,8 +1,9 @@
 // =============================================================================
-// UCI front-end. The search runs on a WORKER THREAD so the main thread keeps
-// reading stdin and can abort it (`stop`, or starting a new game mid-search)
-// via stop_search(). This is what makes "New Game while the engine is thinking"
-// responsive instead of freezing until the old search finishes.
+// UCI front-end. The search runs on the SearchEngine's own pool threads
+// (SearchEngine::start returns at once) so the main thread keeps reading stdin
+// and can abort it (`stop`, or starting a new game mid-search). This is what
+// makes "New Game while the engine is thinking" responsive instead of freezing
+// until the old search finishes.
 // =============================================================================
 
 #include <algorithm>
@@ -13,7 +14,6 @@
 #include <mutex>
 #include <sstream>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include "chess/position.hpp"
@@ -27,11 +27,13 @@ using namespace chess;
 
 namespace {
 
-std::thread g_worker;
-std::mutex  g_cout;   // serializes stdout between the worker and the main thread
-OpeningBook g_book;
-bool        g_own_book = true;
-int         g_threads  = 1;   // Lazy SMP: parallel search threads (UCI option)
+SearchEngine g_engine;
+std::mutex   g_cout;   // serializes stdout between the search and the main thread
+OpeningBook  g_book;
+bool         g_own_book = true;
+int          g_threads  = 1;       // Lazy SMP: parallel search threads (UCI option)
+int          g_multipv  = 1;       // lines to search and report (UCI option)
+bool         g_pin_threads = false; // bind search thread i to CPU i (UCI option)
 std::vector<std::uint64_t> g_history;   // zobrist keys of the game, for repetition
 
 std::string square_to_uci(Square s) {
@@ -49,77 +51,130 @@ std::string move_to_uci(Move m) {
     return s;
 }
 
+// Decode a UCI move ("e2e4", "e7e8q") into from/to/promotion and match those
+// fields against the legal moves (no string built per candidate move).
 Move find_move(Position& pos, const std::string& uci) {
+    if (uci.size() < 4 || uci.size() > 5) return MOVE_NONE;
+    for (int i : {0, 2})
+        if (uci[i] < 'a' || uci[i] > 'h' || uci[i + 1] < '1' || uci[i + 1] > '8') return MOVE_NONE;
+    const Square from = make_square(File(uci[0] - 'a'), Rank(uci[1] - '1'));
+    const Square to   = make_square(File(uci[2] - 'a'), Rank(uci[3] - '1'));
+    PieceType promo = NO_PIECE_TYPE;
+    if (uci.size() == 5) {
+        switch (uci[4]) {
+            case 'n': promo = KNIGHT; break;
+            case 'b': promo = BISHOP; break;
+            case 'r': promo = ROOK;   break;
+            case 'q': promo = QUEEN;  break;
+            default:  return MOVE_NONE;
+        }
+    }
+
     MoveList list;
     generate_legal(pos, list);
     for (Move m : list)
-        if (move_to_uci(m) == uci) return m;
+        if (m.from_sq() == from && m.to_sq() == to
+            && (m.type_of() == PROMOTION ? m.promotion_type() : NO_PIECE_TYPE) == promo)
+            return m;
     return MOVE_NONE;
 }
 
-// Abort and join any in-progress search (no-op if idle).
+// Abort any in-progress search and wait until it has printed its bestmove
+// (no-op if idle).
 void stop_and_join() {
-    if (g_worker.joinable()) {
-        stop_search();
-        g_worker.join();
-    }
+    g_engine.stop();
+    g_engine.wait();
 }
 
+// The last `position` command as applied to the board: its base ("startpos" or
+// the FEN) and the move tokens played from it. GUIs resend the whole game before
+// every `go`; when the new command only appends moves we play just those.
+// Cleared whenever the board is changed some other way (ucinewgame).
+std::string              g_pos_base;
+std::vector<std::string> g_pos_moves;
+
 // position [startpos | fen <6 fields>] [moves <m1> <m2> ...]
 void cmd_position(Position& pos, std::istringstream& is) {
-    std::string token;
+    std::string token, base;
     if (!(is >> token)) return;
 
     if (token == "startpos") {
-        pos.set_startpos();
+        base = token;
     } else if (token == "fen") {
-        std::string fen, part;
+        std::string part;
         for (int i = 0; i < 6 && (is >> part); ++i)
-            fen += (i ? " " : "") + part;
-        pos.set_fen(fen);
+            base += (i ? " " : "") + part;
     } else {
         return;
     }
 
-    g_history.clear();
-    g_history.push_back(pos.key());
-    while (is >> token) {
-        if (token == "moves") continue;
-        Move m = find_move(pos, token);
+    std::vector<std::string> moves;
+    while (is >> token)
+        if (token != "moves") moves.push_back(token);
+
+    // Same base and the moves we already played are a prefix: keep the board.
+    const bool extends = !g_pos_base.empty() && base == g_pos_base
+                         && moves.size() >= g_pos_moves.size()
+                         && std::equal(g_pos_moves.begin(), g_pos_moves.end(), moves.begin());
+    if (!extends) {
+        if (base == "startpos") pos.set_startpos();
+        else                    pos.set_fen(base);
+        g_pos_base = base;
+        g_pos_moves.clear();
+        g_history.clear();
+        g_history.push_back(pos.key());
+    }
+
+    for (std::size_t i = g_pos_moves.size(); i < moves.size(); ++i) {
+        Move m = find_move(pos, moves[i]);
         if (m == MOVE_NONE) break;
         Position::Undo u;
         pos.make_move(m, u);
         g_history.push_back(pos.key());
+        g_pos_moves.push_back(moves[i]);
     }
 }
 
-// The worker body: search, then print info + bestmove (under the cout lock).
-void run_search(Position& pos, SearchLimits lim, std::vector<std::uint64_t> hist) {
-    SearchResult r = search(pos, lim, hist);
+// Called on the search thread with live progress (see SearchInfo).
+void report_info(const SearchInfo& i) {
     std::lock_guard<std::mutex> lk(g_cout);
-    std::cout << "info depth " << r.depth << " score cp " << r.score
-              << " nodes " << r.nodes << " pv " << move_to_uci(r.best) << "\n";
-    std::cout << "bestmove " << move_to_uci(r.best) << std::endl;
+    if (i.kind == SearchInfo::CURRMOVE) {
+        std::cout << "info depth " << i.depth << " currmove " << move_to_uci(i.currmove)
+                  << " currmovenumber " << i.currmovenumber << std::endl;
+        return;
+    }
+    std::cout << "info depth " << i.depth << " seldepth " << i.seldepth;
+    if (i.kind == SearchInfo::LINE) {
+        std::cout << " multipv " << i.multipv << " score cp " << i.score;
+        if (i.bound == BOUND_LOWER) std::cout << " lowerbound";
+        if (i.bound == BOUND_UPPER) std::cout << " upperbound";
+    }
+    std::cout << " nodes " << i.nodes << " nps " << i.nps() << " hashfull " << i.hashfull
+              << " time " << i.time_ms;
+    if (i.kind == SearchInfo::LINE) {
+        std::cout << " pv";
+        for (Move m : i.pv) std::cout << ' ' << move_to_uci(m);
+    }
+    std::cout << std::endl;
 }
 
-// go [depth N] [movetime MS] [nodes N] [wtime MS] [btime MS] [infinite]
+// Called on the search thread when a search ends (the lines were already
+// reported depth by depth).
+void report(const SearchResult& r) {
+    std::lock_guard<std::mutex> lk(g_cout);
+    std::cout << "bestmove " << move_to_uci(r.best);
+    if (r.pv.size() >= 2 && r.pv[0] == r.best)      // the reply we expect: ponder on it
+        std::cout << " ponder " << move_to_uci(r.pv[1]);
+    std::cout << std::endl;
+}
+
+// go [ponder] [depth N] [movetime MS] [nodes N] [wtime MS] [btime MS] [infinite]
 void cmd_go(Position& pos, std::istringstream& is) {
     stop_and_join();   // never decide/print over a running search
 
-    // In book? Play the book move instantly and skip the search.
-    if (g_own_book) {
-        Move bm = g_book.probe(pos);
-        if (bm != MOVE_NONE) {
-            std::lock_guard<std::mutex> lk(g_cout);
-            std::cout << "info string book move\n";
-            std::cout << "bestmove " << move_to_uci(bm) << std::endl;
-            return;
-        }
-    }
-
     int depth = 0, movetime = 0, wtime = 0, btime = 0;
     long long nodes = 0;
-    bool infinite = false;
+    bool infinite = false, ponder = false;
 
     std::string token;
     while (is >> token) {
@@ -129,14 +184,30 @@ void cmd_go(Position& pos, std::istringstream& is) {
         else if (token == "wtime")    is >> wtime;
         else if (token == "btime")    is >> btime;
         else if (token == "infinite") infinite = true;
+        else if (token == "ponder")   ponder = true;
+    }
+
+    // In book? Play the book move instantly and skip the search. Not while
+    // pondering: no bestmove may be sent before ponderhit/stop, so the ponder
+    // search just runs and reports when it ends as usual.
+    if (g_own_book && !ponder) {
+        Move bm = g_book.probe(pos);
+        if (bm != MOVE_NONE) {
+            std::lock_guard<std::mutex> lk(g_cout);
+            std::cout << "info string book move\n";
+            std::cout << "bestmove " << move_to_uci(bm) << std::endl;
+            return;
+        }
     }
 
     SearchLimits lim;
     lim.threads = g_threads;
+    lim.multipv = g_multipv;
     if (depth > 0)    lim.depth = depth;
     if (movetime > 0) lim.movetime_ms = movetime;
     if (nodes > 0)    lim.max_nodes = static_cast<std::uint64_t>(nodes);
     if (infinite)     lim.depth = 64;   // bounded by `stop` now, so this is safe
+    lim.ponder = ponder;                // the time budget waits for `ponderhit`
 
     if (depth == 0 && movetime == 0 && nodes == 0 && !infinite) {
         int myTime = (pos.side_to_move() == WHITE) ? wtime : btime;
@@ -145,8 +216,8 @@ void cmd_go(Position& pos, std::istringstream& is) {
     }
 
     stop_and_join();                      // ensure no prior search is running
-    clear_stop();                         // arm a fresh search BEFORE launching the worker
-    g_worker = std::thread(run_search, std::ref(pos), lim, g_history);
+    g_engine.clear_stop();                // arm a fresh search BEFORE launching it
+    g_engine.start(pos, lim, g_history, report, report_info);
 }
 
 } // namespace
@@ -175,7 +246,10 @@ int main() {
             std::cout << "id author Joao\n";
             std::cout << "option name OwnBook type check default true\n";
             std::cout << "option name Threads type spin default 1 min 1 max 256\n";
+            std::cout << "option name PinThreads type check default false\n";
             std::cout << "option name Hash type spin default 16 min 1 max 4096\n";
+            std::cout << "option name MultiPV type spin default 1 min 1 max 256\n";
+            std::cout << "option name Ponder type check default false\n";
             std::cout << "option name EvalFile type string default <none>\n";
             std::cout << "option name Eval type combo default NNUE var NNUE var HCE\n";
             std::cout << "uciok\n" << std::flush;
@@ -190,15 +264,24 @@ int main() {
                                            if (!value.empty() && value[0] == ' ') value.erase(0, 1); }
             }
             if      (name == "OwnBook") g_own_book = (value == "true");
-            else if (name == "Threads") g_threads = std::max(1, std::atoi(value.c_str()));
-            else if (name == "Hash")    tt_resize(std::atoi(value.c_str()));
+            else if (name == "MultiPV") g_multipv  = std::clamp(std::atoi(value.c_str()), 1, 256);
+            else if (name == "Threads" || name == "PinThreads") {
+                stop_and_join();
+                if (name == "Threads") g_threads     = std::max(1, std::atoi(value.c_str()));
+                else                   g_pin_threads = (value == "true");
+                g_engine.set_threads(g_threads, g_pin_threads);   // the pool lives until the next change
+            }
+            else if (name == "Hash")    { stop_and_join(); g_engine.resize_tt(std::size_t(std::max(1, std::atoi(value.c_str())))); }
             else if (name == "EvalFile") {
+                stop_and_join();
                 bool ok = nnue::load(value);
+                g_engine.clear();       // the TT holds the old net's static evals
                 std::lock_guard<std::mutex> lk(g_cout);
                 std::cout << "info string EvalFile " << (ok ? "loaded: " : "FAILED: ") << value << "\n" << std::flush;
             }
             else if (name == "Eval") {
                 // Switch evaluation: HCE (hand-crafted, default) or NNUE (embedded net).
+                stop_and_join();        // a running NNUE search reads the weights being replaced
                 bool ok = true;
                 if (value == "NNUE")     ok = nnue::is_loaded() || nnue::load_embedded();
                 else /* HCE */           nnue::unload();
@@ -208,15 +291,18 @@ int main() {
             }
         } else if (cmd == "ucinewgame") {
             stop_and_join();
-            tt_clear();
+            g_engine.clear();
             pos.set_startpos();
+            g_pos_base.clear();         // next `position` starts from scratch
         } else if (cmd == "position") {
             stop_and_join();            // don't mutate the board under the worker
             cmd_position(pos, is);
         } else if (cmd == "go") {
             cmd_go(pos, is);
+        } else if (cmd == "ponderhit") {
+            g_engine.ponderhit();       // keep searching, now on our own clock
         } else if (cmd == "stop") {
-            stop_and_join();            // aborts; the worker prints its bestmove
+            stop_and_join();            // aborts; the search prints its bestmove
         } else if (cmd == "quit") {
             break;
         }
@@ -3,10 +3,19 @@
 // Release build's NDEBUG would strip out). Returns non-zero if anything failed,
 // so CTest treats a failure as a failing test.
 
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 #include "chess/book.hpp"
 #include "chess/eval.hpp"
 #include "chess/movegen.hpp"
@@ -17,6 +26,8 @@
 #include "chess/movelist.hpp"
 #include "chess/attacks.hpp"
 #include "chess/nnue.hpp"
+#include "chess/packed.hpp"
+#include "chess/mapped_file.hpp"
 
 using namespace chess;
 
@@ -100,6 +111,27 @@ static std::string snapshot(const Position& p) {
     return os.str();
 }
 
+// The same position with the colours swapped: ranks mirrored, piece case and
+// side to move flipped. A symmetric evaluation scores it identically.
+static std::string flip_fen(const std::string& fen) {
+    std::istringstream is(fen);
+    std::string board, stm, castling, ep, half, full;
+    is >> board >> stm >> castling >> ep >> half >> full;
+    std::vector<std::string> ranks;
+    std::string r;
+    for (char ch : board + "/") {
+        if (ch == '/') { ranks.insert(ranks.begin(), r); r.clear(); continue; }
+        r += std::isalpha(static_cast<unsigned char>(ch))
+           ? char(std::isupper(static_cast<unsigned char>(ch)) ? std::tolower(ch) : std::toupper(ch)) : ch;
+    }
+    std::string out;
+    for (std::size_t i = 0; i < ranks.size(); ++i) out += (i ? "/" : "") + ranks[i];
+    for (char& ch : castling)
+        if (ch != '-') ch = char(std::isupper(static_cast<unsigned char>(ch)) ? std::tolower(ch) : std::toupper(ch));
+    if (ep != "-") ep[1] = char('1' + '8' - ep[1]);
+    return out + (stm == "w" ? " b " : " w ") + castling + " " + ep + " " + half + " " + full;
+}
+
 int main() {
     Position p;
     p.set_startpos();
@@ -295,6 +327,34 @@ int main() {
         CHECK(a.key() == b.key());
     }
 
+    // ---- material+PSQT sums and phase (incremental, like the key) ----
+    {
+        Position s; s.set_startpos();
+        CHECK(s.psq_mg(WHITE) == s.psq_mg(BLACK) && s.psq_eg(WHITE) == s.psq_eg(BLACK));
+        CHECK(s.phase() == 24);                                       // symmetric start, full phase
+        bool ok = true;
+        std::function<void(Position&, int)> walk = [&](Position& pos, int depth) {
+            Position fresh; fresh.set_fen(pos.to_fen());
+            for (Color c : { WHITE, BLACK })
+                ok = ok && pos.psq_mg(c) == fresh.psq_mg(c) && pos.psq_eg(c) == fresh.psq_eg(c);
+            ok = ok && pos.phase() == fresh.phase();
+            if (depth == 0) return;
+            MoveList list;
+            generate_legal(pos, list);
+            for (Move m : list) {
+                Position::Undo u; pos.make_move(m, u);
+                walk(pos, depth - 1);
+                pos.unmake_move(m, u);
+            }
+        };
+        for (const char* fen : { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                 "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" }) {
+            Position pos; pos.set_fen(fen);
+            walk(pos, 2);
+        }
+        CHECK(ok);
+    }
+
     // ---- between_bb / line_bb (for legal movegen) ----
     {
         // a1..a8: between(a1,a4) = a2,a3; line(a1,a4) = whole a-file.
@@ -352,6 +412,51 @@ int main() {
         CHECK(perft(pf, 2) == 1486);
         CHECK(perft(pf, 3) == 62379);
     }
+    {   // generation types: each is exactly its slice of the legal moves, in the same order
+        auto noisy = [](const Position& p, Move m) {
+            return p.piece_on(m.to_sq()) != NO_PIECE || m.type_of() == EN_PASSANT
+                || m.type_of() == PROMOTION;
+        };
+        bool ok = true;
+        std::function<void(Position&, int)> walk = [&](Position& pos, int depth) {
+            MoveList all, caps, quiets, checks, evasions;
+            generate_legal(pos, all);
+            generate_legal<CAPTURES>(pos, caps);
+            generate_legal<QUIETS>(pos, quiets);
+            generate_legal<QUIET_CHECKS>(pos, checks);
+            std::vector<Move> wantCaps, wantQuiets, wantChecks;
+            for (Move m : all) {
+                if (noisy(pos, m)) { wantCaps.push_back(m); continue; }
+                wantQuiets.push_back(m);
+                if (m.type_of() == CASTLING) continue;
+                Position::Undo u; pos.make_move(m, u);
+                if (pos.in_check()) wantChecks.push_back(m);
+                pos.unmake_move(m, u);
+            }
+            ok = ok && std::vector<Move>(caps.begin(), caps.end()) == wantCaps
+                    && std::vector<Move>(quiets.begin(), quiets.end()) == wantQuiets
+                    && std::vector<Move>(checks.begin(), checks.end()) == wantChecks;
+            if (pos.in_check()) {
+                generate_legal<EVASIONS>(pos, evasions);
+                ok = ok && std::vector<Move>(evasions.begin(), evasions.end())
+                        == std::vector<Move>(all.begin(), all.end());
+            }
+            if (depth == 0) return;
+            for (Move m : all) {
+                Position::Undo u; pos.make_move(m, u);
+                walk(pos, depth - 1);
+                pos.unmake_move(m, u);
+            }
+        };
+        for (const char* fen : { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                 "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                                 "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                                 "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8" }) {
+            Position pos; pos.set_fen(fen);
+            walk(pos, 2);
+        }
+        CHECK(ok);
+    }
 
     // ---- NNUE incremental accumulator: the correctness gate ----
     // With a (random) net installed, the incrementally-maintained accumulator must
@@ -377,7 +482,66 @@ int main() {
         walk(pf, 3);
         Position kp; kp.set_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
         walk(kp, 2);   // castling / ep / promotions exercise more put/remove paths
+        CHECK(NnueEval::evaluate(kp) == evaluate(kp));   // the search's policy == the dispatcher
         nnue::unload();   // back to HCE so the eval checks below are unaffected
+        CHECK(HceEval::evaluate(kp) == evaluate(kp));
+    }
+    {   // output buckets: the count comes from the file size, the piece count picks one
+        const char* path = "core_tests_buckets.tmp";
+        auto write_net = [&](int buckets) {
+            std::vector<std::int16_t> w(std::size_t(nnue::INPUT_DIM) * nnue::L1 + nnue::L1
+                                        + std::size_t(buckets) * 2 * nnue::L1);   // all zero
+            for (int b = 0; b < buckets; ++b) w.push_back(std::int16_t(64 * 255 * (b + 1) / 400));
+            std::ofstream f(path, std::ios::binary);
+            f.write(reinterpret_cast<const char*>(w.data()), std::streamsize(w.size() * 2));
+        };
+        Position full; full.set_startpos();                      // 32 pieces: last bucket
+        Position kk;   kk.set_fen("4k3/8/8/8/8/8/8/4K3 w - - 0 1"); // 2 pieces: bucket 0
+        write_net(1);
+        CHECK(nnue::load(path) && nnue::output_buckets() == 1);
+        CHECK(evaluate(full) == evaluate(kk));
+        write_net(8);
+        CHECK(nnue::load(path) && nnue::output_buckets() == 8);
+        CHECK(evaluate(kk) < evaluate(full));
+        CHECK(evaluate(kk) == 0 && evaluate(full) == 7);        // (b+1) cp, truncated
+        write_net(nnue::MAX_OUTPUT_BUCKETS + 1);
+        CHECK(!nnue::load(path) && !nnue::is_loaded());
+        std::remove(path);
+    }
+    {   // save() undoes the load-time weight transform: the file comes back byte for byte
+        const char* path = "core_tests_net.tmp";
+        const char* copy = "core_tests_net_saved.tmp";
+        std::vector<std::int16_t> w(std::size_t(nnue::INPUT_DIM) * nnue::L1 + nnue::L1
+                                    + std::size_t(2) * (2 * nnue::L1 + 1));   // 2 buckets
+        for (std::size_t i = 0; i < w.size(); ++i) w[i] = std::int16_t(int((i * 2654435761u) >> 27) - 16);
+        { std::ofstream f(path, std::ios::binary);
+          f.write(reinterpret_cast<const char*>(w.data()), std::streamsize(w.size() * 2)); }
+        Position kp; kp.set_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        CHECK(nnue::load(path));
+        const int before = evaluate(kp);
+        CHECK(nnue::save(copy));
+        std::ifstream a(path, std::ios::binary), b(copy, std::ios::binary);
+        CHECK(std::string(std::istreambuf_iterator<char>(a), {}) == std::string(std::istreambuf_iterator<char>(b), {}));
+        CHECK(nnue::load(copy) && evaluate(kp) == before);
+        a.close(); b.close();
+        // Again through a real permutation (a rotation: every neuron moves, and it
+        // is not its own inverse): the evals don't change and save() scatters the
+        // weights back to file order.
+        std::vector<std::uint16_t> rotated(nnue::L1);
+        for (int i = 0; i < nnue::L1; ++i) rotated[i] = std::uint16_t((i + 1) % nnue::L1);
+        nnue::set_neuron_order(rotated.data());
+        std::remove(copy);
+        CHECK(nnue::load(path));
+        kp.invalidate_accumulator();
+        CHECK(evaluate(kp) == before);
+        CHECK(nnue::save(copy));
+        nnue::set_neuron_order(nullptr);
+        a.open(path, std::ios::binary); b.open(copy, std::ios::binary);
+        CHECK(std::string(std::istreambuf_iterator<char>(a), {}) == std::string(std::istreambuf_iterator<char>(b), {}));
+        nnue::unload();
+        CHECK(!nnue::save(copy));
+        a.close(); b.close();
+        std::remove(path); std::remove(copy);
     }
 
     // ---- evaluation ----
@@ -393,6 +557,56 @@ int main() {
         Position e; e.set_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/1NBQKBNR b KQk - 0 1");
         CHECK(evaluate(e) > 400);
     }
+    {   // colour symmetry, with king attacks, checks and threats on the board
+        for (const char* fen : { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                 "r1b2rk1/pp3ppp/2n5/3qN2Q/3P4/2PB4/P4PPP/R3R1K1 w - - 0 15",
+                                 "6k1/5p1p/6pB/8/8/5Q2/5PPP/6K1 b - - 0 1",
+                                 "r2q1rk1/ppp2ppp/2np4/2b1p1B1/2B1P1n1/2NP1N2/PPP2PPP/R2Q1RK1 w - - 0 8" }) {
+            Position a; a.set_fen(fen);
+            Position b; b.set_fen(flip_fen(fen));
+            CHECK(evaluate_hce(a) == evaluate_hce(b));
+        }
+    }
+    {   // a piece attacked by a pawn is a threat: knight on d4, pawn to attack it
+        Position e; e.set_fen("4k3/8/2p5/8/3N4/8/8/4K3 b - - 0 1");         // c6 pawn eyes d5 only
+        Position t; t.set_fen("4k3/8/8/2p5/3N4/8/8/4K3 b - - 0 1");         // c5 pawn hits d4
+        CHECK(evaluate_hce(t) - evaluate_hce(e) >= 30);                    // black's view, near-endgame weight
+    }
+
+    // ---- static exchange evaluation ----
+    // Each case's swap value was worked out by hand (P 100, N 320, B 330, R 500,
+    // Q 900); see_ge must hold at the value and one below, and fail one above.
+    {
+        struct SeeCase { const char* fen; Move m; int value; };
+        const SeeCase cases[] = {
+            // undefended pawn
+            { "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", Move::make(SQ_E1, SQ_E5), 100 },
+            // x-rays both ways: Nxe5 Nxe5 Rxe5 Bxe5 Qxe5 (behind the rook) Qxe5
+            // (behind the bishop) = +100 -320 +320 -500 +330 -900 -> -220
+            { "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", Move::make(SQ_D3, SQ_E5), -220 },
+            // the only defender (Ne7) is pinned to its king by Bd6: the pawn is free
+            { "5k2/4n3/3B4/3p4/8/8/8/3R3K w - - 0 1", Move::make(SQ_D1, SQ_D5), 100 },
+            // capture-promotion, king recaptures: the promoted piece counts as
+            // the pawn it was, so +500 -100
+            { "1rk5/P7/8/8/8/8/8/4K3 w - - 0 1", Move::make(SQ_A7, SQ_B8, PROMOTION, QUEEN), 400 },
+            // en passant, recaptured by the c-pawn: +100 -100
+            { "4k3/2p5/8/3pP3/8/8/8/4K3 w - d6 0 1", Move::make(SQ_E5, SQ_D6, EN_PASSANT), 0 },
+            // the king may not recapture: Rd1 guards d5 through the queen, Qxd5 wins a pawn
+            { "8/8/3k4/3p4/8/8/3Q4/3RK3 w - - 0 1", Move::make(SQ_D2, SQ_D5), 100 },
+        };
+        bool ok = true;
+        for (const SeeCase& c : cases) {
+            Position s; s.set_fen(c.fen);
+            const bool below = see_ge(s, c.m, c.value - 1);
+            const bool at    = see_ge(s, c.m, c.value);
+            const bool above = see_ge(s, c.m, c.value + 1);
+            if (!below || !at || above) {
+                std::cerr << "see_ge " << c.fen << ": " << below << at << above << "\n";
+                ok = false;
+            }
+        }
+        CHECK(ok);
+    }
 
     // ---- search ----
     {   // back-rank mate in one: Ra1-a8#
@@ -416,6 +630,219 @@ int main() {
         for (Move m : legal) if (m == r.best) found = true;
         CHECK(found);
     }
+    {   // engines are independent: stopping one leaves the other (and the default) alone
+        Position s; s.set_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+        SearchEngine a(1), b(1);
+        a.stop();
+        CHECK(a.search(s, SearchLimits{4, 0, 0}).best == MOVE_NONE);   // aborted before depth 1
+        CHECK(b.search(s, SearchLimits{4, 0, 0}).best == Move::make(SQ_A1, SQ_A8));
+        CHECK(search(s, SearchLimits{4, 0, 0}).best == Move::make(SQ_A1, SQ_A8));
+        a.clear_stop();
+        CHECK(a.search(s, SearchLimits{4, 0, 0}).best == Move::make(SQ_A1, SQ_A8));
+    }
+    {   // heuristics carry over between searches; clear() restores a fresh engine exactly
+        Position s; s.set_startpos();
+        SearchEngine fresh(1), used(1);
+        const SearchResult ref = fresh.search(s, SearchLimits{7, 0, 0});
+        used.search(s, SearchLimits{7, 0, 0});
+        Position t; t.set_fen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+        used.search(t, SearchLimits{7, 0, 0});
+        used.clear();
+        const SearchResult again = used.search(s, SearchLimits{7, 0, 0});
+        CHECK(again.nodes == ref.nodes && again.best == ref.best && again.score == ref.score);
+    }
+    {   // node budgets are global: N threads share one budget, and the result counts them all
+        Position s; s.set_startpos();
+        SearchEngine one(1), four(1);
+        SearchLimits lim{64, 0, 20000};
+        const SearchResult r1 = one.search(s, lim);
+        CHECK(r1.nodes == 20000);                 // single thread: exact
+        lim.threads = 4;
+        const SearchResult r4 = four.search(s, lim);
+        CHECK(r4.nodes >= 20000 && r4.nodes < 20000 + 4 * 1024 + 64);
+    }
+    {   // no TT cutoffs at PV nodes: a warm table still yields the full depth-N PV
+        Position s; s.set_fen("r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 1 8");
+        SearchEngine e(16);
+        const SearchResult first  = e.search(s, SearchLimits{7, 0, 0});
+        const SearchResult second = e.search(s, SearchLimits{7, 0, 0});   // PV entries are all in the TT
+        CHECK(first.pv.size() >= 6 && second.pv.size() >= 6);
+    }
+    {   // quiescence uses the TT: a second depth-1 search cuts every leaf on the
+        // entries the first stored, and those entries bound the leaf correctly
+        Position s; s.set_fen("r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 1 8");
+        SearchEngine e(16);
+        const SearchResult first = e.search(s, SearchLimits{1, 0, 0});
+        // Every root move leads to a quiescence leaf: the best one was searched
+        // with the full window (exact), the rest failed low at the root, so
+        // their leaves failed high (lower bounds) at or above -score.
+        MoveList legal; generate_legal(s, legal);
+        int leaves = 0;
+        for (Move m : legal) {
+            Position c = s;
+            Position::Undo u;
+            c.make_move(m, u);
+            bool hit;
+            const TTEntry* t = e.tt().probe(c.key(), hit);
+            if (!hit || t->depth != 0) continue;   // a checking move was extended
+            ++leaves;
+            if (m == first.best) CHECK(t->bound == BOUND_EXACT && -t->score == first.score);
+            else                 CHECK(t->bound != BOUND_UPPER && -t->score <= first.score);
+        }
+        CHECK(leaves > 0);
+        const SearchResult second = e.search(s, SearchLimits{1, 0, 0});
+        CHECK(second.best == first.best && second.score == first.score);
+        // The root, then each leaf counted once by negamax and once by the
+        // quiescence call that returns straight from the TT - no captures tried.
+        CHECK(second.nodes < first.nodes && second.nodes <= std::uint64_t(1 + 2 * legal.size()));
+    }
+    {   // the TT's eval slot: a transposition takes its static eval from the entry,
+        // the stored eval is the backend's own, and switching backends empties the table
+        Position s; s.set_startpos();
+        const Move e4 = Move::make(SQ_E2, SQ_E4);
+        Position c = s;
+        Position::Undo u;
+        c.make_move(e4, u);                   // black has no capture: its leaf is the stand-pat
+        SearchEngine e(16);
+        bool hit;
+        e.search(s, SearchLimits{1, 0, 0});
+        TTEntry* t = e.tt().probe(c.key(), hit);
+        CHECK(hit && t->eval == evaluate(c));
+        *t = TTEntry{ c.key(), MOVE_NONE, 0, 0, BOUND_NONE, -700 };   // no cutoff, a planted eval
+        SearchResult r = e.search(s, SearchLimits{1, 0, 0});
+        CHECK(r.best == e4 && r.score == 700);
+
+        nnue::make_random_net(12345);         // HCE -> NNUE: the planted eval must be gone
+        r = e.search(s, SearchLimits{1, 0, 0});
+        c.invalidate_accumulator();
+        t = e.tt().probe(c.key(), hit);
+        CHECK(hit && t->eval == evaluate(c) && t->eval != -700);
+        CHECK(!(r.best == e4 && r.score == 700));
+        nnue::unload();                       // and back: the NNUE evals are dropped
+        e.search(s, SearchLimits{1, 0, 0});
+        t = e.tt().probe(c.key(), hit);
+        CHECK(hit && t->eval == evaluate_hce(c));
+    }
+    {   // MultiPV: each depth reports N distinct root moves, best first; line 1 is the result
+        Position s; s.set_startpos();
+        SearchEngine e(1);
+        SearchLimits lim{5, 0, 0};
+        lim.multipv = 3;
+        std::vector<SearchInfo> infos;
+        SearchResult r;
+        e.start(s, lim, {}, [&](const SearchResult& res) { r = res; },
+                [&](const SearchInfo& i) {
+                    if (i.kind == SearchInfo::LINE && i.bound == BOUND_EXACT) infos.push_back(i);
+                });
+        e.wait();
+        CHECK(infos.size() == 15);
+        bool ok = true;
+        for (std::size_t i = 0; i + 2 < infos.size(); i += 3) {
+            const SearchInfo& a = infos[i]; const SearchInfo& b = infos[i + 1]; const SearchInfo& c = infos[i + 2];
+            ok = ok && a.multipv == 1 && b.multipv == 2 && c.multipv == 3;
+            ok = ok && a.pv[0] != b.pv[0] && a.pv[0] != c.pv[0] && b.pv[0] != c.pv[0];
+            ok = ok && a.score >= b.score && b.score >= c.score;
+        }
+        CHECK(ok);
+        CHECK(r.depth == 5 && r.best != MOVE_NONE);
+        CHECK(!r.pv.empty() && r.pv[0] == r.best);
+        const SearchInfo& top = infos[infos.size() - 3];   // the last depth's multipv 1
+        CHECK(r.best == top.pv[0] && r.score == top.score && r.pv == top.pv);
+        bool legalPvs = true;                     // every reported PV is a playable line
+        for (const SearchInfo& i : infos) {
+            Position q = s;
+            for (Move m : i.pv) {
+                MoveList legal; generate_legal(q, legal);
+                bool found = false;
+                for (Move l : legal) found = found || l == m;
+                if (!found) { legalPvs = false; break; }
+                Position::Undo u; q.make_move(m, u);
+            }
+        }
+        CHECK(legalPvs);
+        CHECK(infos.back().pv.size() >= 3);       // depth 5 reports more than the root move
+        CHECK(infos.back().seldepth >= 5 && infos.back().nodes >= r.nodes);
+        lim.multipv = 50;                         // more lines than legal moves: clamped
+        infos.clear();
+        Position k; k.set_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+        lim.depth = 1;
+        e.start(k, lim, {}, {}, [&](const SearchInfo& i) {
+            if (i.kind == SearchInfo::LINE && i.bound == BOUND_EXACT) infos.push_back(i);
+        });
+        e.wait();
+        MoveList legal; generate_legal(k, legal);
+        CHECK(int(infos.size()) == legal.size());
+    }
+    {   // pondering: no bestmove until ponderhit, even when the depth limit is reached early
+        Position s; s.set_startpos();
+        SearchEngine e(1);
+        SearchLimits lim{3, 0, 0};
+        lim.ponder = true;
+        std::atomic<bool> done{false};
+        SearchResult r;
+        e.start(s, lim, {}, [&](const SearchResult& res) { r = res; done = true; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(!done);
+        e.ponderhit();
+        e.wait();
+        CHECK(done && r.depth == 3 && r.best != MOVE_NONE);
+    }
+
+    // ---- packed training records (bulletformat ChessBoard) ----
+    {   // startpos bytes match bullet's layout: occ, nibbles, kings, score/result
+        Position s; s.set_startpos();
+        PackedBoard b = PackedBoard::pack(s, 35, 1.0);
+        CHECK(b.occ == 0xFFFF00000000FFFFULL);
+        CHECK(b.pcs[0] == 0x13);                // a1 rook (3), b1 knight (1)
+        CHECK((b.pcs[8] & 0xF) == (8 | 0));     // a7: opponent pawn
+        CHECK(b.ksq == SQ_E1 && b.oppKsq == (SQ_E8 ^ 56));
+        CHECK(b.score == 35 && b.result == 2);
+    }
+    {   // black to move: the record is flipped to the mover's view, and every
+        // accessor / unpack() undoes that exactly
+        struct Case { const char* fen; Move best; };
+        const Case cases[] = {
+            {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1", Move::make(SQ_E8, SQ_C8, CASTLING)},
+            {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", Move::make(SQ_E1, SQ_G1, CASTLING)},
+            {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",       Move::make(SQ_E5, SQ_F6, EN_PASSANT)},
+            {"8/8/8/8/8/8/1p4k1/4K3 b - - 0 1",                                     Move::make(SQ_B2, SQ_B1, PROMOTION, KNIGHT)},
+            {"4k3/8/8/8/8/8/8/4K2R w - - 0 1",                                      MOVE_NONE},
+        };
+        for (const Case& c : cases) {
+            Position s; s.set_fen(c.fen);
+            PackedBoard b = PackedBoard::pack(s, -120, 0.0, c.best, 17);
+            Position u; b.unpack(u);
+            Position ref; ref.reset();                 // same pieces, no castling/ep
+            for (int sq = 0; sq < 64; ++sq)
+                if (!s.empty(Square(sq))) ref.put_piece(s.piece_on(Square(sq)), Square(sq));
+            ref.set_state(s.side_to_move());
+            CHECK(u.key() == ref.key());
+            CHECK(u.side_to_move() == s.side_to_move());
+            CHECK(b.white_score() == -120 && b.white_result() == 0.0 && b.ply() == 17);
+            CHECK(b.best_move(u) == c.best);
+        }
+    }
+    {   // text line -> record (normalizing the result token), malformed rejected
+        PackedBoard b;
+        CHECK(parse_text_record("4k3/8/8/8/8/8/8/4K2R b K - 0 30 | 250 | 1", b));
+        CHECK(b.white_score() == 250 && b.white_result() == 1.0);
+        CHECK(b.score == -250 && b.result == 0);        // stored mover-relative
+        CHECK(b.ply() == 59 && b.side_to_move() == BLACK);
+        CHECK(!parse_text_record("4k3/8/8/8/8/8/8/4K2R b K - 0 30 | abc | 1", b));
+        CHECK(!parse_text_record("no separators here", b));
+    }
+    {   // a packed file mapped read-only sees exactly the bytes written
+        const char* path = "core_tests_mapped.tmp";
+        Position s; s.set_startpos();
+        PackedBoard recs[2] = { PackedBoard::pack(s, 10, 0.5), PackedBoard::pack(s, -7, 0.0) };
+        { std::ofstream f(path, std::ios::binary); f.write(reinterpret_cast<const char*>(recs), sizeof(recs)); }
+        MappedFile m;
+        CHECK(m.open(path) && m.size() == sizeof(recs));
+        CHECK(m.is_open() && std::memcmp(m.data(), recs, sizeof(recs)) == 0);
+        m.close();
+        CHECK(!m.is_open() && !m.open("core_tests_no_such_file.bin"));
+        std::remove(path);
+    }
 
     // ---- opening book ----
     {
@@ -15,7 +15,8 @@ with open(out, "w") as f:
     f.write("namespace chess { namespace nnue {\n\n")
     f.write(f"extern const unsigned char EMBEDDED_NET[{len(data)}];\n")
     f.write(f"extern const std::size_t   EMBEDDED_NET_SIZE = {len(data)};\n\n")
-    f.write(f"const unsigned char EMBEDDED_NET[{len(data)}] = {{\n")
+    # Aligned so nnue.cpp can use the weights in place (see load_embedded).
+    f.write(f"alignas(64) const unsigned char EMBEDDED_NET[{len(data)}] = {{\n")
     for i in range(0, len(data), 20):
         chunk = data[i:i+20]
         f.write(" " + "".join(f"{b}," for b in chunk) + "\n")
@@ -1,7 +1,9 @@
 # =============================================================================
 # retrain.ps1 - one-shot NNUE retrain pipeline:
-#   normalize result tokens -> convert to bulletformat -> train (bullet+CUDA)
-# Assumes data/all.txt already generated (tools/training/gen_shards.ps1).
+#   get bulletformat data -> train (bullet+CUDA)
+# Prefers data/all.bin (`gen_data --binary`: already bulletformat, used as-is).
+# Otherwise converts data/all.txt (tools/training/gen_shards.ps1) with our
+# convert_data, which also normalizes the result tokens.
 #
 #   powershell -File tools\training\retrain.ps1
 #
@@ -18,19 +20,19 @@ $env:CUDA_PATH = "C:\Program Files\NVIDIA GPU Computing Toolkit\CUDA\v12.8"
 $env:Path = "$env:CUDA_PATH\bin;" + $env:Path
 
 $repo  = Split-Path -Parent (Split-Path -Parent $PSScriptRoot)   # tools\training\.. \..
-$py    = (Get-Command python).Source
-$utils = Join-Path $BulletDir "target\release\bullet-utils.exe"
+$conv  = "C:\chess_build\bin\convert_data.exe"
+$bin   = Join-Path $DataDir "all.bin"
 
-Write-Host "1/3 normalize result tokens" -ForegroundColor Cyan
-& $py (Join-Path $PSScriptRoot "normalize_results.py") `
-      (Join-Path $DataDir "all.txt") (Join-Path $DataDir "train_norm.txt")
-
-Write-Host "2/3 convert text -> bulletformat" -ForegroundColor Cyan
-& $utils convert --from text --input (Join-Path $DataDir "train_norm.txt") `
-                 --output (Join-Path $DataDir "train.data")
+if (Test-Path $bin) {
+    Write-Host "1/2 using packed data as-is: $bin" -ForegroundColor Cyan
+    Copy-Item $bin (Join-Path $DataDir "train.data") -Force
+} else {
+    Write-Host "1/2 convert text -> bulletformat (normalizes result tokens)" -ForegroundColor Cyan
+    & $conv (Join-Path $DataDir "all.txt") (Join-Path $DataDir "train.data")
+}
 Copy-Item (Join-Path $DataDir "train.data") (Join-Path $BulletDir "data\train.data") -Force
 
-Write-Host "3/3 train (bullet + CUDA)" -ForegroundColor Cyan
+Write-Host "2/2 train (bullet + CUDA)" -ForegroundColor Cyan
 Push-Location $BulletDir
 cargo r -r --features cuda --example chessengine
 Pop-Location